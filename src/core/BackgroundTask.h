@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace internal {
+
+/// Runs 'task' on a separate thread, once every 'period'
+/// The first run happens after a whole period has passed. The thread is stopped and joined on destruction,
+/// without waiting for the current period to end.
+class PeriodicTask {
+public:
+	PeriodicTask(const std::chrono::milliseconds period, std::function<void()> task)
+	    : m_thread{[this, period, task = std::move(task)](std::stop_token stop) {
+		      std::unique_lock lock{m_mutex};
+		      while (!m_wakeup.wait_for(lock, stop, period, [] { return false; }) && !stop.stop_requested())
+			      task();
+	      }} {}
+
+	PeriodicTask(const PeriodicTask &) = delete;
+	PeriodicTask &operator=(const PeriodicTask &) = delete;
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable_any m_wakeup;
+
+	/// Declared last, so that it is joined before the rest of the members are destroyed.
+	std::jthread m_thread;
+};
+
+}// namespace internal
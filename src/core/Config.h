@@ -1,10 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include <concepts>
 #include <cstdint>
 
 #include <core/Util.h>
 #include <core/storage/Pager.h>
+#include <core/storage/ValueCodec.h>
 
 namespace internal {
 
@@ -33,6 +35,56 @@ struct Config {
 	static inline constexpr bool DYN_ENTRIES = false;
 	using RealVal = Val;
 
+	/// Leaf delta chains (as in the Bw-tree)
+	/// When non-zero, small leaf changes - insertion, update or removal of a single entry - are appended to the
+	/// leaf page as compact delta records instead of re-encoding the whole node. The chain is folded into the
+	/// node once it grows to LEAF_DELTA_CHAIN records or the LEAF_DELTA_AREA bytes at the tail of the page are used up.
+	static inline constexpr int LEAF_DELTA_CHAIN = 0;
+	static inline constexpr std::size_t LEAF_DELTA_AREA = 512;
+
+	/// Leaf key compression
+	/// When set and 'Key' is integral, leaves store their keys as a base key followed by bit-packed differences
+	/// from it. Leaves are then limited by the size of their encoding rather than by a fixed number of entries,
+	/// thus dense ranges of keys fit many more entries per leaf.
+	static inline constexpr bool PACK_LEAF_KEYS = false;
+
+	/// Columnar (PAX) leaves
+	/// When set and 'Columns<Val>' is specialized, each field of the values in a leaf is stored in its own contiguous
+	/// column inside the page. Scans over a single field then decode only the keys and that column.
+	static inline constexpr bool COLUMNAR_LEAVES = false;
+
+	/// Entry expiration (TTL)
+	/// When set, each entry carries an expiration time after which reads treat it as absent. Expired entries are
+	/// removed from the tree by 'Btree::purge_expired()'. ENTRY_TTL is the lifetime of the entries which are inserted
+	/// without an explicit one, zero meaning that they never expire.
+	static inline constexpr bool TTL_ENTRIES = false;
+	static inline constexpr std::chrono::milliseconds ENTRY_TTL{0};
+
+	/// Value log (key-value separation)
+	/// When set, dynamic values are appended to a log of VALUE_LOG_SEGMENT_SIZE-byte segments instead of being
+	/// allocated inside the pages of the slot pager. Replaced and removed values are reclaimed by
+	/// 'Btree::collect_garbage()', which rewrites the segments in which at least VALUE_LOG_GC_RATIO of the bytes
+	/// are garbage, thus the log takes up at most about 1 / (1 - VALUE_LOG_GC_RATIO) times the live data.
+	static inline constexpr bool VALUE_LOG = false;
+	static inline constexpr std::size_t VALUE_LOG_SEGMENT_SIZE = 4_MB;
+	static inline constexpr double VALUE_LOG_GC_RATIO = 0.5;
+
+	/// Compaction of the dynamic values
+	/// 'Btree::compact_values()' empties the Slots pages which are at most COMPACTION_MAX_FILL full by moving their
+	/// values into the rest of the pages, and gives the emptied pages back to the page allocator.
+	static inline constexpr double COMPACTION_MAX_FILL = 0.5;
+
+	/// Decoded-value cache
+	/// When non-zero, up to VALUE_CACHE_SIZE bytes of recently read dynamic values are kept decoded in memory, so
+	/// reading them again touches neither the pager nor the deserializer.
+	static inline constexpr std::size_t VALUE_CACHE_SIZE = 0;
+
+	/// Compression of the dynamic values
+	/// Each dynamic value is encoded with 'ValueCodec' before it is stored, e.g 'storage::DictionaryCodec' which
+	/// compresses the values against a dictionary shared by all of them. The codec is trained from a sample of the
+	/// stored values by 'Btree::train_value_codec()' and persisted along with the tree.
+	using ValueCodec = storage::NoValueCodec;
+
 	using BasicAuthConfig = std::tuple<std::string, std::string>;
 };
 
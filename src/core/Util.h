@@ -237,6 +237,14 @@ int random_item<int>() {
 	//	return dist(rng);
 }
 
+template<>
+long random_item<long>() {
+	static std::random_device dev;
+	static std::mt19937_64 rng(dev());
+	static std::uniform_int_distribution<long> dist(std::numeric_limits<long>::min(), std::numeric_limits<long>::max());
+	return dist(rng);
+}
+
 template<>
 float random_item<float>() {
 	return static_cast<float>(random_item<int>()) / static_cast<float>(random_item<int>());
@@ -14,6 +14,8 @@ class CredentialsStorage {
 		using RealVal = std::string;
 		using Ref = std::string;
 		static inline constexpr bool DYN_ENTRIES = true;
+		/// Password hashes are read on every authentication.
+		static inline constexpr std::size_t VALUE_CACHE_SIZE = 64 * 1024;
 	};
 
 protected:
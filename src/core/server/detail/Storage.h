@@ -1,10 +1,14 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string_view>
 #include <variant>
 
 #include <core/server/detail/Storage.h>
 #include <core/storage/btree/Btree.h>
+#include <core/BackgroundTask.h>
 #include <core/Config.h>
 
 template<typename KEY, typename Value>
@@ -14,35 +18,68 @@ class Storage {
 		using RealVal = std::string;
 		using Ref = std::string;
 		static inline constexpr bool DYN_ENTRIES = true;
+		static inline constexpr bool TTL_ENTRIES = true;
+		static inline constexpr bool VALUE_LOG = true;
 	};
 
+	/// How often expired entries get discarded from the storage and the space of the dropped values is reclaimed
+	static inline constexpr std::chrono::minutes PURGE_PERIOD{1};
+
 protected:
-	internal::storage::btree::Btree<ExampleAgentConfig> m_storage;
 	using BtreeType = internal::storage::btree::Btree<ExampleAgentConfig>;
 
+	/// The tree is shared between the copies of the storage and the purging task.
+	struct State {
+		std::mutex mutex;
+		BtreeType tree;
+
+		~State() {
+			tree.save();
+		}
+	};
+	std::shared_ptr<State> m_state = std::make_shared<State>();
+	std::shared_ptr<internal::PeriodicTask> m_purge = std::make_shared<internal::PeriodicTask>(
+	        PURGE_PERIOD, [state = std::weak_ptr<State>(m_state)] {
+		        if (auto locked = state.lock(); locked) {
+			        std::lock_guard guard{locked->mutex};
+			        [[maybe_unused]] const auto num_purged = locked->tree.purge_expired();
+			        [[maybe_unused]] const auto num_collected = locked->tree.collect_garbage();
+		        }
+	        });
+
 public:
 	virtual void set(const KEY &key, const Value &value) {
-		if (auto res = m_storage.insert(key, value);
+		std::lock_guard guard{m_state->mutex};
+		if (auto res = m_state->tree.insert(key, value);
+			std::holds_alternative<typename BtreeType::InsertedNothing>(res)) {
+			throw std::invalid_argument("Information already exists");
+		}
+	}
+
+	/// Same as 'set', but the entry becomes unavailable once 'lifetime' passes, e.g session tokens.
+	virtual void set(const KEY &key, const Value &value, const std::chrono::milliseconds lifetime) {
+		std::lock_guard guard{m_state->mutex};
+		if (auto res = m_state->tree.insert(key, value, lifetime);
 			std::holds_alternative<typename BtreeType::InsertedNothing>(res)) {
 			throw std::invalid_argument("Information already exists");
 		}
 	}
 
 	virtual Value get(const KEY &key) {
-		if (auto res = m_storage.get(key); res)
+		std::lock_guard guard{m_state->mutex};
+		if (auto res = m_state->tree.get(key); res)
 			return *res;
 		throw std::invalid_argument("Can't find such key");
 	}
 
 	virtual void remove(const KEY &key) {
-		if (auto res = m_storage.remove(key);
+		std::lock_guard guard{m_state->mutex};
+		if (auto res = m_state->tree.remove(key);
 			std::holds_alternative<typename BtreeType::RemovedNothing>(res)) {
 			throw std::invalid_argument("Can't find such key");
 		}
 	};
 
 	Storage() = default;
-	virtual ~Storage() {
-		m_storage.save();
-	};
+	virtual ~Storage() = default;
 };
\ No newline at end of file
@@ -1,10 +1,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <ranges>
 #include <nop/base/serializer.h>
 #include <nop/utility/buffer_reader.h>
 #include <nop/utility/buffer_writer.h>
-#include <sstream>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -21,6 +29,8 @@
 #include <core/Config.h>
 #include <core/Util.h>
 #include <core/storage/Pager.h>
+#include <core/storage/ValueCodec.h>
+#include <core/storage/ValueLog.h>
 
 namespace internal::storage {
 
@@ -28,21 +38,98 @@ struct BadIndVector : std::runtime_error {
 	explicit BadIndVector(std::string_view msg) : std::runtime_error{fmt::format("Eugene: Bad indirection vector {}", msg.data())} {}
 };
 
+/// A free slot is a link in the list of free slots - its 'pos' is the id of the next free slot.
 struct Slot {
 	storage::Position pos = 0;
 	std::size_t size = 0;
-	bool occupied;
+	bool occupied = false;
 
 	NOP_STRUCTURE(Slot, pos, size, occupied);
 };
 
 using SlotId = std::size_t;
 
+/// Bounded cache of decoded dynamic values
+/// Values are charged with their size in memory plus the size of their encoding, which approximates the memory they
+/// own. The least-recently used ones are evicted once the total exceeds the budget.
+/// Each invalidation starts a new generation of the cache. A value is only placed if no invalidation happened since the
+/// generation in which it was read, thus a value which was replaced meanwhile could not be cached.
+template<typename RealVal>
+class DecodedValueCache {
+	struct CacheEntry {
+		RealVal m_val;
+		std::size_t m_size;
+		std::list<SlotId>::const_iterator m_cit;
+	};
+
+public:
+	explicit DecodedValueCache(const std::size_t budget) : m_budget{budget} {}
+
+	[[nodiscard]] std::optional<RealVal> get(const SlotId n) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		auto it = m_index.find(n);
+		if (it == m_index.end())
+			return {};
+		m_tracker.splice(m_tracker.cend(), m_tracker, it->second.m_cit);
+		return it->second.m_val;
+	}
+
+	[[nodiscard]] uint64_t generation() {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		return m_generation;
+	}
+
+	void place(const SlotId n, const RealVal &val, const uint64_t generation) {
+		const auto size = sizeof(RealVal) + nop::Encoding<RealVal>::Size(val);
+		if (size > m_budget)
+			return;
+
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		if (generation != m_generation)
+			return;
+		__erase(n);
+		while (m_used + size > m_budget)
+			__erase(m_tracker.front());
+		m_tracker.push_back(n);
+		m_index.emplace(n, CacheEntry{.m_val = val, .m_size = size, .m_cit = std::prev(m_tracker.cend())});
+		m_used += size;
+	}
+
+	void erase(const SlotId n) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		++m_generation;
+		__erase(n);
+	}
+
+	[[nodiscard]] std::size_t used() const noexcept { return m_used; }
+
+private:
+	void __erase(const SlotId n) {
+		if (auto it = m_index.find(n); it != m_index.end()) {
+			m_used -= it->second.m_size;
+			m_tracker.erase(it->second.m_cit);
+			m_index.erase(it);
+		}
+	}
+
+private:
+	const std::size_t m_budget;
+	std::size_t m_used = 0;
+	uint64_t m_generation = 0;
+	std::unordered_map<SlotId, CacheEntry> m_index;
+	std::list<SlotId> m_tracker;
+	std::mutex m_mutex;
+};
+
 template<EugeneConfig Config>
 class IndirectionVector {
 	using Val = typename Config::Val;
 	using RealVal = typename Config::RealVal;
 	using PagerType = typename Config::PagerType;
+	using Codec = typename Config::ValueCodec;
+
+	static constexpr bool ENCODE_VALUES = !std::same_as<Codec, NoValueCodec>;
+	static constexpr bool CACHE_VALUES = Config::VALUE_CACHE_SIZE > 0;
 
 public:
 	enum class ActionOnConstruction { Load,
@@ -51,6 +138,10 @@ public:
 	template<typename... Args>
 	explicit IndirectionVector(std::string identifier = "/tmp/eu-btree", ActionOnConstruction action = ActionOnConstruction::Load, Args &&...args)
 	    : m_identifier{identifier}, m_slot_pager{std::make_shared<PagerType>(fmt::format("{}-pager", identifier), std::forward<Args>(args)...)} {
+		if constexpr (CACHE_VALUES)
+			m_value_cache = std::make_shared<DecodedValueCache<RealVal>>(Config::VALUE_CACHE_SIZE);
+		if constexpr (Config::VALUE_LOG)
+			m_value_log = std::make_shared<ValueLog>(fmt::format("{}-vlog", identifier), Config::VALUE_LOG_SEGMENT_SIZE, Config::VALUE_LOG_GC_RATIO);
 		fmt::print("[ind-vector] instantiating '{}'\n", identifier);
 		// clang-format off
 		switch (action) {
@@ -68,19 +159,33 @@ public:
 	///
 
 	/// Load indirection vector from persistent storage
+	/// Only the header is read - the pages of the slot table are read lazily, once a slot in them is accessed.
 	void load() {
 		fmt::print("[ind-vector] loading '{}'\n", header_name().data());
 		if constexpr (requires { m_slot_pager->load(); })
 			m_slot_pager->load();
+		if constexpr (Config::VALUE_LOG)
+			m_value_log->load();
+		if constexpr (ENCODE_VALUES) {
+			nop::Deserializer<nop::StreamReader<std::ifstream>> deserializer{codec_name()};
+			Codec codec;
+			if (!deserializer.Read(&codec))
+				throw BadRead("deserializer fails reading value codec");
+			if constexpr (requires { codec.load(); })
+				codec.load();
+			m_codec = std::move(codec);
+		}
 		nop::Deserializer<nop::StreamReader<std::ifstream>> deserializer{header_name().data()};
 		auto backup = *this;
 		if (!deserializer.Read(this)) {
 			*this = backup;//< In case of erroneous read, recover saved version.
 			throw BadRead("deserializer fails reading indirection vector");
 		}
+		m_table_pages.clear();
 	}
 
 	/// Store indirection vector from persistent storage
+	/// Only the header and the slot table pages which were modified since they were read are written.
 	void save() {
 		fmt::print("[ind-vector] saving '{}'\n", header_name());
 		if constexpr (requires { m_slot_pager->save(); })
@@ -88,104 +193,414 @@ public:
 		nop::Serializer<nop::StreamWriter<std::ofstream>> serializer{header_name().data(), std::ios::trunc};
 		if (!serializer.Write(*this))
 			throw BadWrite("serializer fails writing indirection vector");
+		if constexpr (ENCODE_VALUES) {
+			nop::Serializer<nop::StreamWriter<std::ofstream>> codec_serializer{codec_name(), std::ios::trunc};
+			if (!codec_serializer.Write(m_codec))
+				throw BadWrite("serializer fails writing value codec");
+		}
+		/// Saved last, since segments collected since the previous save are dropped only once the slots
+		/// referring to their new positions are stored.
+		if constexpr (Config::VALUE_LOG)
+			m_value_log->save();
 	}
 
 	/// Set dyn value in a slot
 	SlotId set_to_slot(const RealVal &val) {
-		nop::Serializer<nop::StreamWriter<std::stringstream>> serializer;
-		if (!serializer.Write(val))
-			throw BadWrite(fmt::format("serializer fails writing val_data for slot", val));
-		const auto str = serializer.writer().stream().str();
-		std::vector<uint8_t> val_data{str.cbegin(), str.cend()};
-		const auto sz = val_data.size();
-#if 1
-		nop::Deserializer<nop::StreamReader<std::stringstream>> deserializer{str};
-		RealVal deserialized;
-		deserializer.Read(&deserialized);
-		if (deserialized == val)
-			fmt::print("[ind-vector] serialized '{}' ('{}') matches deserialization output\n", val, val_data);
-		else
-			fmt::print("[ERR][ind-vector] serialized '{}' does not match deserialization output ('{}')\n", val, deserialized);
-#endif
-
-		const auto pos = m_slot_pager->alloc_inner(sz);
-		fmt::print("[ind-vector] setting realval = '{}' (sz = {}, pos = {})\n", val, sz, pos);
-		m_slot_pager->place_inner(pos, val_data);
-#if 1
-		auto retrieved_val = m_slot_pager->get_inner(pos, val_data.size());
-		if (retrieved_val == val_data)
-			fmt::print("[ind-vector] inner retrieved matches emplaced\n");
-		else
-			fmt::print("[ERR][ind-vector] inner retrieved does not match emplaced\n");
-#endif
 		auto slot_id = alloc_slot();
-		m_slots.emplace(m_slots.cbegin() + slot_id, pos, sz);
+		const auto [pos, sz] = place_value(val, slot_id);
+		write_slot(slot_id, Slot{.pos = pos, .size = sz, .occupied = true});
 		return slot_id;
 	}
 
 	/// Update dyn value in an existing slot
-	void replace_in_slot(const SlotId n, const RealVal &new_val, const auto new_val_sz) {
-		if (n >= m_slots.size())
-			throw BadRead(fmt::format("trying to access slot = {} but out of bounds", n));
-
-		auto new_val_pos = m_slot_pager->alloc_inner(new_val_sz);
-		std::vector<uint8_t> new_val_data{new_val_sz};
-		nop::Serializer<nop::BufferWriter> serializer{new_val_data.data(), new_val_sz};
-		if (!serializer.Write(new_val))
-			throw BadWrite(fmt::format("serializer fails updating with new_val for slot", n));
-		m_slot_pager->place_inner(new_val_pos, new_val_data);
-
-		const auto &slot = m_slots.at(n);
-		m_slot_pager->free_inner(slot.pos, slot.size);
-		m_slots[n] = Slot{.pos = new_val_pos, .size = new_val_sz};
+	/// The cached value is invalidated only once the slot refers to the new value (see 'DecodedValueCache').
+	void replace_in_slot(const SlotId n, const RealVal &new_val) {
+		const auto slot = read_slot(n);
+		const auto [new_val_pos, new_val_sz] = place_value(new_val, n);
+		free_value(slot);
+		write_slot(n, Slot{.pos = new_val_pos, .size = new_val_sz, .occupied = true});
+		if constexpr (CACHE_VALUES)
+			m_value_cache->erase(n);
 	}
 
 	/// Free up a slot
 	void remove_slot(const SlotId n) {
-		if (n >= m_slots.size())
-			throw BadRead(fmt::format("trying to access slot = {} but out of bounds", n));
-		const auto &slot = m_slots.at(n);
-
-		m_slot_pager->free_inner(slot.pos, slot.size);
+		const auto slot = read_slot(n);
+		free_value(slot);
 		free_slot(n);
+		if constexpr (CACHE_VALUES)
+			m_value_cache->erase(n);
 	}
 
 	/// Read a dyn value from slot
+	/// Recently read values are served from the decoded-value cache, if there is one.
 	[[nodiscard]] RealVal get_from_slot(const SlotId n) {
-		if (n >= m_slots.size())
-			throw BadRead(fmt::format("trying to access slot (={}) out of bounds", n));
-		const auto &slot = m_slots.at(n);
-		fmt::print("[ind-vector] getting realval (sz = {}, pos = {}, @slot_id = {})\n", slot.pos, slot.size, n);
-		auto val_data = m_slot_pager->get_inner(slot.pos, slot.size);
-		fmt::print("[indvector] getting val_data = '{}'\n", val_data);
-		RealVal val;
-		nop::Deserializer<nop::BufferReader> deserializer{val_data.data(), val_data.size()};
-		if (!deserializer.Read(&val))
-			throw BadRead(fmt::format("deserializer fails reading val_data for slot", n));
+		[[maybe_unused]] uint64_t generation = 0;
+		if constexpr (CACHE_VALUES) {
+			if (auto cached = m_value_cache->get(n); cached)
+				return std::move(*cached);
+			generation = m_value_cache->generation();
+		}
+
+		const auto slot = read_slot(n);
+		auto val_data = read_value(slot);
+		auto val = decode_value(val_data.data(), val_data.size(), n);
+		if constexpr (CACHE_VALUES)
+			m_value_cache->place(n, val, generation);
 		return val;
 	}
 
+	/// Read the dyn values of many slots at once
+	/// The slots are visited in the order of their position in the pager, so that each of its pages is read once
+	/// and all values are decoded in a single pass. The returned values are aligned with 'ids'.
+	/// Cached values are used, but the values which are read are not cached, so that scans do not evict hot ones.
+	[[nodiscard]] std::vector<RealVal> get_from_slots(const std::ranges::random_access_range auto &ids) {
+		const auto num_ids = static_cast<std::size_t>(std::ranges::size(ids));
+		std::vector<RealVal> vals(num_ids);
+		std::vector<std::size_t> order;
+		order.reserve(num_ids);
+		for (std::size_t i = 0; i < num_ids; ++i) {
+			if constexpr (CACHE_VALUES) {
+				if (auto cached = m_value_cache->get(static_cast<SlotId>(ids[i])); cached) {
+					vals[i] = std::move(*cached);
+					continue;
+				}
+			}
+			order.push_back(i);
+		}
+
+		std::vector<Slot> slots(num_ids);
+		SlotTableCursor cursor;
+		for (const auto i : order)
+			slots[i] = read_slot(static_cast<SlotId>(ids[i]), cursor);
+		std::ranges::sort(order, {}, [&](const std::size_t i) { return slots[i].pos; });
+
+		std::vector<std::pair<storage::Position, std::size_t>> ranges;
+		ranges.reserve(order.size());
+		for (const auto i : order)
+			ranges.emplace_back(slots[i].pos, slots[i].size);
+
+		auto decode = [&](const std::size_t i, const uint8_t *data, const std::size_t sz) {
+			vals[order[i]] = decode_value(data, sz, ids[order[i]]);
+		};
+		if constexpr (Config::VALUE_LOG)
+			m_value_log->read_many(ranges, decode);
+		else
+			m_slot_pager->get_inner_many(ranges, decode);
+		return vals;
+	}
+
+	/// Incremental compaction of the Slots pages
+	/// A pass drains the Slots pages which are at most 'Config::COMPACTION_MAX_FILL' full - no values are allocated in
+	/// them anymore - and walks the slot table, moving each value stored in them to the rest of the pages. Each call
+	/// continues the current pass until about 'io_budget' bytes of values have been moved or of slot records have been
+	/// read, so that compaction can be interleaved with the rest of the operations. Once the whole table has been
+	/// walked, the emptied pages are given back to the page allocator.
+	/// A pass is started only if there are at least two sparse pages or an empty one, otherwise moving the values
+	/// would not give back any page. Returns whether there is no pass in progress anymore.
+	bool compact(const std::size_t io_budget) requires(!Config::VALUE_LOG) {
+		if (!m_compaction) {
+			const auto sparse = m_slot_pager->sparse_slots_pages(Config::COMPACTION_MAX_FILL);
+			if (sparse.size() < 2 && m_slot_pager->sparse_slots_pages(0.0).empty())
+				return true;
+			m_slot_pager->drain(sparse);
+			m_compaction = CompactionPass{.pages = {sparse.begin(), sparse.end()}};
+		}
+
+		auto &pass = *m_compaction;
+		std::size_t spent = 0;
+		SlotTableCursor cursor;
+		for (; pass.cursor < m_num_slots && spent < io_budget; ++pass.cursor) {
+			spent += SLOT_RECORD_SIZE;
+			const auto slot = read_slot_record(pass.cursor, cursor);
+			if (!slot.occupied || !pass.touches(slot))
+				continue;
+
+			/// The value is copied before its slot is updated, so the slot refers to a complete value at all times.
+			const auto [pos, sz] = place_bytes(read_value(slot), pass.cursor);
+			write_slot(pass.cursor, Slot{.pos = pos, .size = sz, .occupied = true});
+			free_value(slot);
+			spent += 2 * slot.size;
+		}
+
+		if (pass.cursor < m_num_slots)
+			return false;
+		m_slot_pager->release_drained();
+		m_compaction.reset();
+		return true;
+	}
+
+	/// Rewrite the value log segments which are mostly garbage, moving their live values to its head
+	/// Returns the number of collected segments.
+	std::size_t collect_garbage() requires(Config::VALUE_LOG) {
+		auto is_live = [&](const uint64_t owner, const storage::Position pos) {
+			if (owner >= m_num_slots)
+				return false;
+			const auto slot = read_slot_record(owner);
+			return slot.occupied && slot.pos == pos;
+		};
+		auto relocate = [&](const uint64_t owner, const storage::Position new_pos) {
+			auto slot = read_slot_record(owner);
+			slot.pos = new_pos;
+			write_slot(owner, slot);
+		};
+		return m_value_log->collect_garbage(is_live, relocate);
+	}
+
+	/// Train the value codec on a sample of at most 'max_samples' of the stored values
+	/// The values are sampled evenly across the slot table. Since the values which are already stored cannot be
+	/// decoded by the trained codec, each of them gets re-encoded with it.
+	void train_codec(const std::size_t max_samples) requires(ENCODE_VALUES) {
+		std::vector<std::vector<uint8_t>> samples;
+		std::vector<uint8_t> plain;
+		SlotTableCursor cursor;
+		const auto stride = std::max<std::size_t>(1, m_num_slots / std::max<std::size_t>(1, max_samples));
+		for (SlotId n = 0; n < m_num_slots && samples.size() < max_samples; n += stride) {
+			if (const auto slot = read_slot_record(n, cursor); slot.occupied) {
+				m_codec.decode(read_value(slot), plain);
+				samples.push_back(plain);
+			}
+		}
+
+		auto trained = m_codec;
+		trained.train(samples);
+
+		std::vector<uint8_t> encoded;
+		for (SlotId n = 0; n < m_num_slots; ++n) {
+			const auto slot = read_slot_record(n);
+			if (!slot.occupied)
+				continue;
+			m_codec.decode(read_value(slot), plain);
+			trained.encode(plain, encoded);
+			const auto [pos, sz] = place_bytes(encoded, n);
+			free_value(slot);
+			write_slot(n, Slot{.pos = pos, .size = sz, .occupied = true});
+		}
+		m_codec = std::move(trained);
+	}
+
 private:
 	///
 	/// Slots API
 	///
 
-	[[nodiscard]] SlotId alloc_slot() {
-		auto it = std::find_if(m_slots.cbegin(), m_slots.cend(), [&](const auto &slot) {
-			return !slot.occupied;
+	/// Store the encoding of 'val', owned by slot 'owner', in the slot pager or in the value log
+	/// Unless it has to go through the codec or the value log, the value is serialized right into the pager's page,
+	/// since its encoded size is computed up front.
+	[[nodiscard]] std::pair<storage::Position, std::size_t> place_value(const RealVal &val, [[maybe_unused]] const SlotId owner) {
+		const auto sz = nop::Encoding<RealVal>::Size(val);
+		if constexpr (Config::VALUE_LOG || ENCODE_VALUES) {
+			std::vector<uint8_t> data(sz);
+			nop::Serializer<nop::BufferWriter> serializer{data.data(), data.size()};
+			if (!serializer.Write(val))
+				throw BadWrite("serializer fails writing val_data for slot");
+			if constexpr (ENCODE_VALUES) {
+				std::vector<uint8_t> encoded;
+				m_codec.encode(data, encoded);
+				return place_bytes(encoded, owner);
+			} else {
+				return place_bytes(data, owner);
+			}
+		}
+		const auto pos = m_slot_pager->alloc_inner(sz);
+		const bool written = m_slot_pager->place_inner_with(pos, sz, [&val](uint8_t *data, const std::size_t size) {
+			nop::Serializer<nop::BufferWriter> serializer{data, size};
+			return static_cast<bool>(serializer.Write(val));
+		});
+		if (!written) {
+			m_slot_pager->free_inner(pos, sz);
+			throw BadWrite("serializer fails writing val_data for slot");
+		}
+		return {pos, sz};
+	}
+
+	/// Store already encoded data, owned by slot 'owner'
+	[[nodiscard]] std::pair<storage::Position, std::size_t> place_bytes(std::span<const uint8_t> data, [[maybe_unused]] const SlotId owner) {
+		if constexpr (Config::VALUE_LOG)
+			return {m_value_log->append(owner, data), data.size()};
+		const auto pos = m_slot_pager->alloc_inner(data.size());
+		m_slot_pager->place_inner_with(pos, data.size(), [&data](uint8_t *page_data, const std::size_t size) {
+			std::memcpy(page_data, data.data(), size);
+			return true;
 		});
+		return {pos, data.size()};
+	}
+
+	/// Read the data stored for a slot, as it was passed to 'place_bytes'
+	[[nodiscard]] std::vector<uint8_t> read_value(const Slot &slot) {
+		if constexpr (Config::VALUE_LOG)
+			return m_value_log->read(slot.pos, slot.size);
+		else
+			return m_slot_pager->get_inner(slot.pos, slot.size);
+	}
 
-		return static_cast<SlotId>([&] {
-			if (it == m_slots.cend())
-				return static_cast<SlotId>(std::distance(it, m_slots.cbegin()));
-			m_slots.emplace_back();
-			return m_slots.size() - 1;
-		}());
+	[[nodiscard]] RealVal decode_value(const uint8_t *data, std::size_t sz, [[maybe_unused]] const SlotId n) {
+		if constexpr (ENCODE_VALUES) {
+			thread_local std::vector<uint8_t> plain;
+			m_codec.decode({data, sz}, plain);
+			data = plain.data();
+			sz = plain.size();
+		}
+		RealVal val;
+		nop::Deserializer<nop::BufferReader> deserializer{data, sz};
+		if (!deserializer.Read(&val))
+			throw BadRead(fmt::format("deserializer fails reading val_data for slot {}", n));
+		return val;
+	}
+
+	void free_value(const Slot &slot) {
+		if constexpr (Config::VALUE_LOG)
+			m_value_log->free(slot.pos, slot.size);
+		else
+			m_slot_pager->free_inner(slot.pos, slot.size);
+	}
+
+	/// Both allocating and freeing a slot are O(1) - free slots form an intrusive list (see 'Slot'),
+	/// whose head is the most recently freed slot.
+	[[nodiscard]] SlotId alloc_slot() {
+		if (m_free_slots == NO_FREE_SLOT) {
+			const auto slot_id = m_num_slots++;
+			if (slot_id % SLOTS_PER_PAGE == 0)
+				append_slot_table_page(slot_id / SLOTS_PER_PAGE);
+			return slot_id;
+		}
+
+		const auto slot_id = m_free_slots;
+		m_free_slots = static_cast<SlotId>(read_slot_record(slot_id).pos);
+		return slot_id;
 	}
 
 	void free_slot(SlotId slot_id) {
-		if (slot_id <= m_slots.size())
-			m_slots[slot_id].occupied = false;
+		if (slot_id >= m_num_slots)
+			return;
+		write_slot(slot_id, Slot{.pos = static_cast<storage::Position>(m_free_slots), .size = 0, .occupied = false});
+		m_free_slots = slot_id;
+	}
+
+	///
+	/// Slot table
+	///
+	/// The slot table is stored in the pages of the slot pager as a two-level radix array. The header keeps the
+	/// positions of the directory pages, each of them lists the positions of up to 'TABLE_PAGES_PER_DIRECTORY'
+	/// table pages, and each table page holds 'SLOTS_PER_PAGE' fixed-size slot records.
+	/// A record consists of the position of the value, followed by its size whose highest bit is the occupied flag.
+	///
+
+	static constexpr std::size_t SLOT_TABLE_HEADER_SIZE = sizeof(uint64_t);
+	static constexpr std::size_t SLOT_RECORD_SIZE = 2 * sizeof(uint64_t);
+	static constexpr std::size_t SLOTS_PER_PAGE = (PAGE_SIZE - SLOT_TABLE_HEADER_SIZE) / SLOT_RECORD_SIZE;
+	static constexpr std::size_t TABLE_PAGES_PER_DIRECTORY = (PAGE_SIZE - SLOT_TABLE_HEADER_SIZE) / sizeof(uint64_t);
+	static constexpr uint64_t SLOT_OCCUPIED_BIT = uint64_t{1} << 63;
+
+	/// State of the compaction pass in progress
+	struct CompactionPass {
+		/// The drained pages
+		std::unordered_set<storage::Position> pages;
+		/// The next slot to visit
+		SlotId cursor = 0;
+
+		/// Whether any part of the value of 'slot' is in one of the drained pages
+		[[nodiscard]] bool touches(const Slot &slot) const {
+			const auto last = slot.pos + std::max<std::size_t>(slot.size, 1) - 1;
+			for (auto page_pos = slot.pos / PAGE_SIZE * PAGE_SIZE; page_pos <= last; page_pos += PAGE_SIZE)
+				if (pages.contains(page_pos))
+					return true;
+			return false;
+		}
+	};
+
+	/// The last table page that was read, so that reading neighbouring slots does not acquire it again.
+	struct SlotTableCursor {
+		std::optional<std::size_t> table_idx;
+		Page page;
+	};
+
+	[[nodiscard]] static uint64_t read_word(const Page &page, const std::size_t offset) {
+		uint64_t word;
+		std::memcpy(&word, page.data() + offset, sizeof(word));
+		return word;
+	}
+
+	static void write_word(Page &page, const std::size_t offset, const uint64_t word) {
+		std::memcpy(page.data() + offset, &word, sizeof(word));
+	}
+
+	[[nodiscard]] static std::size_t record_offset(const SlotId n) {
+		return SLOT_TABLE_HEADER_SIZE + n % SLOTS_PER_PAGE * SLOT_RECORD_SIZE;
+	}
+
+	[[nodiscard]] static Page slot_table_page() {
+		Page page{};
+		page[0] = static_cast<uint8_t>(PageType::SlotTable);
+		return page;
+	}
+
+	/// Position of the table page with index 'table_idx'
+	/// The positions are resolved from the directory pages once and kept in 'm_table_pages' afterwards.
+	[[nodiscard]] storage::Position table_page_pos(const std::size_t table_idx) {
+		if (table_idx >= (m_num_slots + SLOTS_PER_PAGE - 1) / SLOTS_PER_PAGE)
+			throw BadRead(fmt::format("trying to access slot table page (={}) out of bounds", table_idx));
+		while (m_table_pages.size() <= table_idx) {
+			const auto directory = m_slot_pager->get(m_directory.at(m_table_pages.size() / TABLE_PAGES_PER_DIRECTORY));
+			do {
+				m_table_pages.push_back(read_word(directory, SLOT_TABLE_HEADER_SIZE + m_table_pages.size() % TABLE_PAGES_PER_DIRECTORY * sizeof(uint64_t)));
+			} while (m_table_pages.size() <= table_idx && m_table_pages.size() % TABLE_PAGES_PER_DIRECTORY != 0);
+		}
+		return m_table_pages[table_idx];
+	}
+
+	void append_slot_table_page(const std::size_t table_idx) {
+		if (table_idx % TABLE_PAGES_PER_DIRECTORY == 0) {
+			m_directory.push_back(m_slot_pager->alloc());
+			m_slot_pager->place(m_directory.back(), slot_table_page());
+		}
+
+		const auto table_pos = m_slot_pager->alloc();
+		m_slot_pager->place(table_pos, slot_table_page());
+		m_slot_pager->modify(m_directory.back(), [&](Page &directory) {
+			write_word(directory, SLOT_TABLE_HEADER_SIZE + table_idx % TABLE_PAGES_PER_DIRECTORY * sizeof(uint64_t), table_pos);
+		});
+		if (m_table_pages.size() == table_idx)
+			m_table_pages.push_back(table_pos);
+	}
+
+	/// Read the record of slot 'n', be it occupied or not
+	[[nodiscard]] Slot read_slot_record(const SlotId n, SlotTableCursor &cursor) {
+		if (n >= m_num_slots)
+			throw BadRead(fmt::format("trying to access slot (={}) out of bounds", n));
+		if (const auto table_idx = n / SLOTS_PER_PAGE; cursor.table_idx != table_idx) {
+			cursor.page = m_slot_pager->get(table_page_pos(table_idx));
+			cursor.table_idx = table_idx;
+		}
+		const auto offset = record_offset(n);
+		const auto size_and_flags = read_word(cursor.page, offset + sizeof(uint64_t));
+		return Slot{.pos = read_word(cursor.page, offset), .size = size_and_flags & ~SLOT_OCCUPIED_BIT, .occupied = (size_and_flags & SLOT_OCCUPIED_BIT) != 0};
+	}
+
+	[[nodiscard]] Slot read_slot_record(const SlotId n) {
+		SlotTableCursor cursor;
+		return read_slot_record(n, cursor);
+	}
+
+	/// Read the record of slot 'n', which has to be occupied
+	[[nodiscard]] Slot read_slot(const SlotId n, SlotTableCursor &cursor) {
+		auto slot = read_slot_record(n, cursor);
+		if (!slot.occupied)
+			throw BadRead(fmt::format("trying to access slot (={}) which is free", n));
+		return slot;
+	}
+
+	[[nodiscard]] Slot read_slot(const SlotId n) {
+		SlotTableCursor cursor;
+		return read_slot(n, cursor);
+	}
+
+	void write_slot(const SlotId n, const Slot &slot) {
+		m_slot_pager->modify(table_page_pos(n / SLOTS_PER_PAGE), [&](Page &page) {
+			const auto offset = record_offset(n);
+			write_word(page, offset, slot.pos);
+			write_word(page, offset + sizeof(uint64_t), slot.size | (slot.occupied ? SLOT_OCCUPIED_BIT : 0));
+		});
 	}
 
 public:
@@ -195,12 +610,39 @@ public:
 
 	[[nodiscard]] std::string header_name() const noexcept { return m_identifier; }
 
+	[[nodiscard]] std::string codec_name() const noexcept { return fmt::format("{}-codec", m_identifier); }
+
+	/// Number of slots in the table, both occupied and free ones
+	[[nodiscard]] std::size_t num_slots() const noexcept { return m_num_slots; }
+
+	/// Utilization of the Slots pages in which the values are allocated
+	[[nodiscard]] FragmentationReport fragmentation_report() requires(!Config::VALUE_LOG) { return m_slot_pager->fragmentation_report(); }
+
+	[[nodiscard]] const ValueLog &value_log() const requires(Config::VALUE_LOG) { return *m_value_log; }
+
+	[[nodiscard]] const DecodedValueCache<RealVal> &value_cache() const requires(CACHE_VALUES) { return *m_value_cache; }
+
 private:
-	std::vector<Slot> m_slots;
+	static constexpr SlotId NO_FREE_SLOT = std::numeric_limits<SlotId>::max();
+
 	std::string m_identifier;
 	std::shared_ptr<PagerType> m_slot_pager;
-
-	NOP_STRUCTURE(IndirectionVector, m_slots, m_identifier);
+	/// Holds the values instead of the slot pager when 'Config::VALUE_LOG' is set
+	std::shared_ptr<ValueLog> m_value_log;
+	/// Persisted separately from the header, in 'codec_name()'
+	[[no_unique_address]] Codec m_codec;
+	/// Present when 'Config::VALUE_CACHE_SIZE' is non-zero
+	std::shared_ptr<DecodedValueCache<RealVal>> m_value_cache;
+	std::optional<CompactionPass> m_compaction;
+	std::size_t m_num_slots = 0;
+	/// Head of the list of free slots
+	SlotId m_free_slots = NO_FREE_SLOT;
+	/// Positions of the directory pages of the slot table
+	std::vector<storage::Position> m_directory;
+	/// Positions of the table pages which were resolved from the directory so far
+	std::vector<storage::Position> m_table_pages;
+
+	NOP_STRUCTURE(IndirectionVector, m_identifier, m_num_slots, m_free_slots, m_directory);
 };
 
 }// namespace internal::storage
@@ -127,6 +127,18 @@ TEST_CASE("Page cache with LRU policy", "[pager]") {
 	REQUIRE(cache.get(5 * PAGE_SIZE)->get() == p);
 	REQUIRE(std::find(evict_res2->page.cbegin(), evict_res2->page.cend(), 1) != evict_res2->page.cend());
 	REQUIRE(evict_res2->pos == 1 * PAGE_SIZE);
+
+	/// Clean pages are dropped on eviction, unless they get modified afterwards.
+	PageCache<LRUCache> clean_cache(4);
+	REQUIRE(!clean_cache.place(0 * PAGE_SIZE, Page(p), false));
+	REQUIRE(!clean_cache.place(1 * PAGE_SIZE, Page(p), false));
+	REQUIRE(!clean_cache.place(1 * PAGE_SIZE, Page(p)));
+	REQUIRE(!clean_cache.place(2 * PAGE_SIZE, Page(p)));
+	std::vector<Position> written;
+	for (auto evict_res : clean_cache.flush())
+		if (evict_res)
+			written.push_back(evict_res->pos);
+	REQUIRE(written == std::vector<Position>{1 * PAGE_SIZE, 2 * PAGE_SIZE});
 }
 
 TEST_CASE("Pager inner operations") {
@@ -192,6 +204,92 @@ TEST_CASE("Pager inner operations") {
 		auto actual2222 = pt.get_inner(pos5000, 2222);
 		REQUIRE(std::equal(expected2222.cbegin(), expected2222.cend(), actual2222.cbegin()));
 	}
+
+	SECTION("Allocations across page boundaries") {
+		PagerType pt{"/tmp/eu-pager-inner-across-pages"};
+
+		/// Enough to fill up a few pages, so that some of the values span two of them
+		std::vector<std::pair<Position, std::vector<uint8_t>>> placed;
+		for (uint8_t i = 0; i < 250; ++i) {
+			std::vector<uint8_t> data(50, i);
+			auto pos = pt.alloc_inner(data.size());
+			pt.place_inner(pos, data);
+			placed.emplace_back(pos, std::move(data));
+		}
+		for (const auto &[pos, data] : placed)
+			REQUIRE(pt.get_inner(pos, data.size()) == data);
+	}
+
+	SECTION("Writing data in place") {
+		PagerType pt{"/tmp/eu-pager-inner-place-with"};
+		auto fill = [](const uint8_t byte) {
+			return [byte](uint8_t *data, const std::size_t sz) {
+				std::fill_n(data, sz, byte);
+				return true;
+			};
+		};
+
+		auto pos30 = pt.alloc_inner(30);
+		REQUIRE(pt.place_inner_with(pos30, 30, fill(30)));
+		REQUIRE(pt.get_inner(pos30, 30) == std::vector<uint8_t>(30, 30));
+
+		/// Spans more than a single page
+		auto pos5000 = pt.alloc_inner(5000);
+		REQUIRE(pt.place_inner_with(pos5000, 5000, fill(50)));
+		REQUIRE(pt.get_inner(pos5000, 5000) == std::vector<uint8_t>(5000, 50));
+
+		/// Reading many ranges at once, sorted by position
+		const std::array<std::pair<Position, std::size_t>, 3> ranges{{{pos30, 30}, {pos30 + 10, 5}, {pos5000, 5000}}};
+		std::array<std::vector<uint8_t>, 3> read;
+		pt.get_inner_many(ranges, [&](const std::size_t i, const uint8_t *data, const std::size_t sz) { read[i].assign(data, data + sz); });
+		REQUIRE(read[0] == std::vector<uint8_t>(30, 30));
+		REQUIRE(read[1] == std::vector<uint8_t>(5, 30));
+		REQUIRE(read[2] == std::vector<uint8_t>(5000, 50));
+
+		/// Failed writes are reported, the data could be written again
+		REQUIRE(!pt.place_inner_with(pos30, 30, [](uint8_t *, const std::size_t) { return false; }));
+		REQUIRE(pt.place_inner_with(pos30, 30, fill(31)));
+		REQUIRE(pt.get_inner(pos30, 30) == std::vector<uint8_t>(30, 31));
+	}
+
+	SECTION("Fragmentation report") {
+		PagerType pt{"/tmp/eu-pager-inner-fragmentation"};
+		REQUIRE(pt.fragmentation_report().slots_pages == 0);
+
+		std::vector<Position> positions;
+		for (int i = 0; i < 200; ++i)
+			positions.push_back(pt.alloc_inner(40));
+		auto report = pt.fragmentation_report();
+		REQUIRE(report.slots_pages == 3);
+		REQUIRE(report.allocated_bytes == 3 * PAGE_SIZE);
+		REQUIRE(report.live_bytes == 200 * 40);
+		REQUIRE(report.live_bytes == pt.max_bytes_inner_used());
+
+		/// The pages of a loaded pager are read from the disk.
+		pt.save();
+		PagerType loaded{"/tmp/eu-pager-inner-fragmentation", ActionOnConstruction::Load};
+		REQUIRE(loaded.fragmentation_report().live_bytes == report.live_bytes);
+
+		/// Freeing every other value leaves holes which are too scattered to give back any page.
+		for (std::size_t i = 0; i < positions.size(); i += 2)
+			pt.free_inner(positions[i], 40);
+		report = pt.fragmentation_report();
+		REQUIRE(report.live_bytes == 100 * 40);
+		REQUIRE(report.empty_slots_pages == 0);
+		REQUIRE(report.free_runs.at(5) >= 99);
+		REQUIRE(report.largest_free_run >= 40);
+		REQUIRE(report.space_amplification() > 3.0);
+		REQUIRE(report.compaction_gain() == 1 * PAGE_SIZE);
+
+		for (std::size_t i = 1; i < positions.size(); i += 2)
+			pt.free_inner(positions[i], 40);
+		report = pt.fragmentation_report();
+		REQUIRE(report.live_bytes == 0);
+		REQUIRE(report.empty_slots_pages == 3);
+		REQUIRE(report.free_runs.at(std::bit_width(TRACKED_CHUNKS * PAGE_ALLOC_SCALE) - 1) == 3);
+		REQUIRE(report.largest_free_run == TRACKED_CHUNKS * PAGE_ALLOC_SCALE);
+		REQUIRE(report.compaction_gain() == 3 * PAGE_SIZE);
+	}
 }
 
 TEST_CASE("Pager concurrency") {
@@ -5,14 +5,19 @@
 #include <bitset>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <filesystem>
 #include <fstream>
 #include <list>
+#include <map>
 #include <mutex>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 namespace fs = std::filesystem;
 
 #include <cppcoro/async_mutex.hpp>
@@ -32,7 +37,8 @@ namespace fs = std::filesystem;
 namespace internal::storage {
 
 enum class PageType : uint8_t { Node,
-	                        Slots };
+	                        Slots,
+	                        SlotTable };
 
 constexpr static std::size_t PAGE_SIZE = 4_KB;
 constexpr static std::size_t PAGE_ALLOC_SCALE = 4_B;
@@ -53,7 +59,7 @@ using Position = unsigned long int;
 using Page = std::array<std::uint8_t, PAGE_SIZE>;
 
 constexpr Page SlotPage() {
-	Page p;
+	Page p{};
 	p[0] = static_cast<uint8_t>(PageType::Slots);
 	return p;
 }
@@ -70,6 +76,38 @@ struct PagePos {
 	Position pos;
 };
 
+/// Chunks of a Slots page which are tracked by its chunk bitmap
+constexpr static std::size_t TRACKED_CHUNKS = CHUNK_MAP_SIZE * CHAR_BIT;
+
+/// Utilization of the pages used for inner allocations
+struct FragmentationReport {
+	/// Pages handed out by the allocator, of any type
+	std::size_t pages = 0;
+	std::size_t slots_pages = 0;
+	/// Slots pages without a single allocated chunk
+	std::size_t empty_slots_pages = 0;
+
+	/// Bytes in allocated chunks
+	std::size_t live_bytes = 0;
+	/// Bytes taken up by the Slots pages
+	std::size_t allocated_bytes = 0;
+
+	/// Number of runs of free chunks by their size - the runs of [2^k, 2^(k+1)) bytes are counted under k
+	std::map<unsigned, std::size_t> free_runs;
+	std::size_t largest_free_run = 0;
+
+	/// Bytes which would be given back if the live chunks were packed into as few Slots pages as possible
+	[[nodiscard]] std::size_t compaction_gain() const noexcept {
+		constexpr auto page_capacity = TRACKED_CHUNKS * PAGE_ALLOC_SCALE;
+		const auto needed_pages = (live_bytes + page_capacity - 1) / page_capacity;
+		return (slots_pages - std::min(slots_pages, needed_pages)) * PAGE_SIZE;
+	}
+
+	[[nodiscard]] double space_amplification() const noexcept {
+		return live_bytes == 0 ? 0.0 : static_cast<double>(allocated_bytes) / static_cast<double>(live_bytes);
+	}
+};
+
 /// Marks whether any additional action should be performed when constructing a Pager instance
 enum class ActionOnConstruction : uint8_t {
 	Load,
@@ -234,10 +272,16 @@ public:
 		return __has_allocated(pos);
 	}
 
+	/// The state is copied up front, so that the lock is not held while the caller handles the pages - reading one
+	/// from the disk checks whether it has been allocated.
 	[[nodiscard]] cppcoro::generator<Position> next_allocated_page() const noexcept {
-		std::scoped_lock<std::mutex> _guard{m_mutex};
-		for (Position i = 0; i < m_next_page * PAGE_SIZE; i += PAGE_SIZE) {
-			if (__has_allocated(i)) {
+		const auto [next_page, freelist] = [&] {
+			std::scoped_lock<std::mutex> _guard{m_mutex};
+			return std::make_pair(m_next_page, m_freelist);
+		}();
+
+		for (Position i = 0; i < next_page * PAGE_SIZE; i += PAGE_SIZE) {
+			if (!collection_contains(freelist, i)) {
 				co_yield i;
 			}
 		}
@@ -285,7 +329,8 @@ public:
 		return it->second.m_page;
 	}
 
-	[[nodiscard]] constexpr CacheEvictionResult place(Position pos, Page &&page) {
+	/// Pages which are only read from the disk are placed as clean ones, thus they are never written back.
+	[[nodiscard]] constexpr CacheEvictionResult place(Position pos, Page &&page, bool dirty = true) {
 		CacheEvictionResult evict_res;
 
 		std::scoped_lock<std::mutex> _guard{m_mutex};
@@ -297,16 +342,31 @@ public:
 		} else {
 			/// Move it to the end of `m_tracker`.
 			m_tracker.splice(m_tracker.cend(), m_tracker, it->second.m_cit);
+			dirty = dirty || it->second.m_dirty;
 		}
 
 		m_index[pos] = CacheEntry{
 		        .m_page = page,
 		        .m_cit = m_tracker.cend(),
-		        .m_dirty = true};
+		        .m_dirty = dirty};
 
 		return evict_res;
 	}
 
+	/// Modify a cached page in place and mark it as dirty. Returns false if the page is not in the cache.
+	template<typename Fn>
+	requires std::is_invocable_v<Fn, Page &>
+	[[nodiscard]] bool modify(Position pos, Fn &&fn) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		const auto it = m_index.find(pos);
+		if (it == m_index.end())
+			return false;
+
+		fn(it->second.m_page);
+		it->second.m_dirty = true;
+		return true;
+	}
+
 	[[nodiscard]] cppcoro::generator<CacheEvictionResult> flush() {
 		std::scoped_lock<std::mutex> _guard{m_mutex};
 		while (!m_tracker.empty())
@@ -454,13 +514,13 @@ public:
 	    : Super{limit_page_cache_size, std::forward<Args>(args)...},
 	      m_identifier{identifier} {
 		fmt::print("[pager] instantiating '{}'\n", m_identifier);
-		if (action == ActionOnConstruction::Load)
-			load();
-		else if (!fs::exists(m_identifier))
-			/// Create an empty storage iff we should not load and the storage does not yet exist.
+		if (!fs::exists(m_identifier))
+			/// Create an empty storage iff it does not yet exist.
 			m_disk.open(m_identifier, std::ios::trunc | std::ios::in | std::ios::out);
 		else
 			m_disk.open(m_identifier, std::ios::in | std::ios::out);
+		if (action == ActionOnConstruction::Load)
+			load();
 	}
 
 	virtual ~Pager() noexcept {
@@ -531,7 +591,7 @@ private:
 		if (auto p = this->m_cache.get(pos); p)
 			return p->get();
 		Page p = read(pos);
-		if (auto evict_res = this->m_cache.place(pos, Page(p)); evict_res)
+		if (auto evict_res = this->m_cache.place(pos, Page(p), false); evict_res)
 			write(evict_res->page, evict_res->pos);
 		return p;
 	}
@@ -541,6 +601,16 @@ private:
 			write(evict_res->page, evict_res->pos);
 	}
 
+	/// Modify the page right inside of the cache, rather than copying it out and placing it back.
+	template<typename Fn>
+	void __modify(Position pos, Fn &&fn) {
+		if (this->m_cache.modify(pos, fn))
+			return;
+		Page p = read(pos);
+		fn(p);
+		__place(pos, std::move(p));
+	}
+
 public:
 	///
 	/// Operations on whole pages
@@ -560,6 +630,15 @@ public:
 		return __place(pos, std::move(page));
 	}
 
+	/// Modify the page at a given position in place, by calling 'fn(Page &)'.
+	/// Same as 'get' followed by 'place', but the page is not copied if it is in the cache.
+	template<typename Fn>
+	requires std::is_invocable_v<Fn, Page &>
+	void modify(const Position pos, Fn &&fn) {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		__modify(pos, std::forward<Fn>(fn));
+	}
+
 	///
 	/// Persistence API
 	///
@@ -620,6 +699,30 @@ private:
 		return (pos / PAGE_SIZE) * PAGE_SIZE;
 	}
 
+	static constexpr std::size_t CHUNK_WORDS = (CHUNK_MAP_SIZE + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	/// Word 'i' of the chunk bitmap of a page, along with the number of chunks it tracks
+	[[nodiscard]] static std::pair<uint64_t, unsigned> chunk_word(const Page &p, const std::size_t i) {
+		const auto bytes = std::min(sizeof(uint64_t), CHUNK_MAP_SIZE - i * sizeof(uint64_t));
+		uint64_t word = 0;
+		std::memcpy(&word, p.data() + PAGE_TYPE_METADATA + i * sizeof(uint64_t), bytes);
+		return {word, static_cast<unsigned>(bytes * CHAR_BIT)};
+	}
+
+	[[nodiscard]] static std::size_t used_chunks(const Page &p) {
+		std::size_t used = 0;
+		for (std::size_t i = 0; i < CHUNK_WORDS; ++i)
+			used += std::popcount(chunk_word(p, i).first);
+		return used;
+	}
+
+	/// Acquire a page without placing it in the cache, so that walking all pages does not evict the hot ones.
+	[[nodiscard]] Page __peek(const Position pos) {
+		if (auto p = this->m_cache.get(pos); p)
+			return p->get();
+		return read(pos);
+	}
+
 public:
 	///
 	/// Implementation of inner operations
@@ -630,17 +733,105 @@ public:
 		std::scoped_lock<std::mutex> _guard{this->m_mutex};
 		std::size_t chunks = 0;
 		for (Position page_pos : this->m_allocator.next_allocated_page())
-			for (const auto &[_, bitval] : chunkbit_iter(__get(page_pos)))
-				chunks += static_cast<std::size_t>(bitval);
+			if (const auto page = __peek(page_pos); page.front() == static_cast<uint8_t>(PageType::Slots))
+				chunks += used_chunks(page);
 		return chunks * PAGE_ALLOC_SCALE;
 	}
 
+	/// Report the utilization of the Slots pages
+	/// The chunk bitmaps are processed a word at a time - the allocated chunks are counted with popcount and the
+	/// runs of free ones are measured by counting trailing ones and zeros. A run is not continued across pages.
+	[[nodiscard]] FragmentationReport fragmentation_report() {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		FragmentationReport report;
+
+		auto close_run = [&report](std::size_t &run) {
+			if (run == 0)
+				return;
+			const auto bytes = run * PAGE_ALLOC_SCALE;
+			++report.free_runs[std::bit_width(bytes) - 1];
+			report.largest_free_run = std::max(report.largest_free_run, bytes);
+			run = 0;
+		};
+
+		for (Position page_pos : this->m_allocator.next_allocated_page()) {
+			++report.pages;
+			const auto page = __peek(page_pos);
+			if (page.front() != static_cast<uint8_t>(PageType::Slots))
+				continue;
+
+			++report.slots_pages;
+			report.allocated_bytes += PAGE_SIZE;
+			const auto used = used_chunks(page);
+			report.live_bytes += used * PAGE_ALLOC_SCALE;
+			if (used == 0)
+				++report.empty_slots_pages;
+
+			std::size_t run = 0;
+			for (std::size_t i = 0; i < CHUNK_WORDS; ++i) {
+				const auto [word, num_bits] = chunk_word(page, i);
+				const auto free = ~word;
+				for (unsigned bit = 0; bit < num_bits;) {
+					const auto rest = free >> bit;
+					if (rest & 1) {
+						const auto len = std::min<unsigned>(std::countr_one(rest), num_bits - bit);
+						run += len;
+						bit += len;
+					} else {
+						close_run(run);
+						bit += std::min<unsigned>(std::countr_zero(rest), num_bits - bit);
+					}
+				}
+			}
+			close_run(run);
+		}
+
+		return report;
+	}
+
+	///
+	/// Compaction of the Slots pages
+	///
+
+	/// Slots pages in which at most 'max_fill' of the chunks are allocated
+	[[nodiscard]] std::vector<Position> sparse_slots_pages(const double max_fill) {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		std::vector<Position> sparse;
+		for (Position page_pos : this->m_allocator.next_allocated_page())
+			if (const auto page = __peek(page_pos); page.front() == static_cast<uint8_t>(PageType::Slots))
+				if (static_cast<double>(used_chunks(page)) <= max_fill * TRACKED_CHUNKS)
+					sparse.push_back(page_pos);
+		return sparse;
+	}
+
+	/// Stop making inner allocations in 'pages', so that they can be emptied by moving their data elsewhere
+	void drain(const std::span<const Position> pages) {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		m_draining.insert(pages.begin(), pages.end());
+	}
+
+	/// Hand the drained pages which no longer contain any allocations back to the page allocator
+	/// The rest of them are used for inner allocations once again. Returns the number of released pages.
+	std::size_t release_drained() {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		std::size_t released = 0;
+		for (const auto page_pos : m_draining) {
+			if (used_chunks(__peek(page_pos)) != 0)
+				continue;
+			/// Pages cannot be freed with this allocator, but the empty ones are still going to be filled again.
+			if constexpr (!std::same_as<AllocatorPolicy, StackSpaceAllocator>)
+				this->m_allocator.free(page_pos);
+			++released;
+		}
+		m_draining.clear();
+		return released;
+	}
+
 	/// Allocate 'sz' number of bytes space inside consecutive pages
 	/// Uses the allocation metadata in the header of the page.
 	/// Utilizes linear probing during search.
 	/// If a valid sz value is passed, then the allocation always succeeds.
 	Position alloc_inner(std::size_t sz) override {
-		fmt::print("trying to lock\n");
 		std::scoped_lock<std::mutex> _guard{this->m_mutex};
 
 		if (sz == 0)
@@ -673,10 +864,12 @@ public:
 				marked_pages.emplace(page_pos, std::move(page));
 		};
 
-		fmt::print("locked\n");
-
 		/// Try to fill in a page that has already been started but is not yet full.
 		for (Position page_pos : this->m_allocator.next_allocated_page()) {
+			if (m_draining.contains(page_pos)) {
+				reset();
+				continue;
+			}
 			auto page = __get(page_pos);
 			if (page.front() != static_cast<uint8_t>(PageType::Slots)) {
 				reset();
@@ -684,6 +877,7 @@ public:
 			}
 			if (prev_page_pos && prev_page_pos.value() != page_pos - PAGE_SIZE)
 				reset();
+			prev_page_pos = page_pos;
 
 			alloc_in_page(page, page_pos);
 			if (curr_chunks >= target_chunks)
@@ -695,6 +889,10 @@ public:
 			auto new_page = SlotPage();
 			auto new_page_pos = this->m_allocator.alloc();
 			fmt::print("[Additional] inner alloc allocates page @{}\n", new_page_pos);
+			/// An allocation may continue in the next page only if it is adjacent.
+			if (prev_page_pos && prev_page_pos.value() != new_page_pos - PAGE_SIZE)
+				reset();
+			prev_page_pos = new_page_pos;
 			alloc_in_page(new_page, new_page_pos);
 			__place(new_page_pos, std::move(new_page));
 		}
@@ -703,19 +901,16 @@ public:
 		assert(curr_chunks == target_chunks);
 
 		/// Mark used pages and save.
+		/// The chunks are counted rather than compared by position, since the headers of the pages lie in between.
+		auto chunks_left = target_chunks;
 		for (auto &[mppos, mp] : marked_pages) {
 			fmt::print("[pager-inner] allocating in page @{}\n", mppos);
-			for (auto [chunk_num, _] : chunkbit_iter(mp)) {
-				auto chpos = chunk_to_position(mppos, chunk_num);
-				if (chpos >= start_pos && chpos < start_pos + sz)
-					chunkbit(mp, chunk_num, true);
-			}
-			fmt::print("before place()\n");
+			auto chunk_num = mppos == page_pos_of(start_pos) ? position_to_chunk(start_pos) : 0u;
+			for (; chunk_num < CHUNK_MAP_SIZE * CHAR_BIT && chunks_left > 0; ++chunk_num, --chunks_left)
+				chunkbit(mp, chunk_num, true);
 			__place(mppos, std::move(mp));
-			fmt::print("after place()\n");
 		}
 
-		fmt::print("getting out...\n");
 		return start_pos;
 	}
 
@@ -783,6 +978,74 @@ public:
 		}
 	}
 
+	/// Same as 'get_inner', but for many <position, size> ranges which are sorted by their position
+	/// All of them are read under a single lock and each page is acquired once, rather than once per range.
+	/// 'read(i, const uint8_t *, std::size_t)' is invoked with the bytes of the i-th range, which point right
+	/// inside the page unless the range spans more than one.
+	template<typename Reader>
+	requires std::is_invocable_v<Reader, std::size_t, const uint8_t *, std::size_t>
+	void get_inner_many(std::span<const std::pair<Position, std::size_t>> ranges, Reader &&read) {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		std::optional<Position> curr_pgpos;
+		Page page;
+		auto page_at = [&](const Position pgpos) -> const Page & {
+			if (curr_pgpos != pgpos) {
+				page = __get(pgpos);
+				curr_pgpos = pgpos;
+			}
+			return page;
+		};
+
+		std::vector<uint8_t> data;
+		for (std::size_t i = 0; i < ranges.size(); ++i) {
+			auto [pos, sz] = ranges[i];
+			auto start_pos = pos % PAGE_SIZE;
+			auto pgpos = page_pos_of(pos);
+			assert(start_pos >= PAGE_HEADER_SIZE);
+			if (start_pos + sz <= PAGE_SIZE) {
+				read(i, page_at(pgpos).data() + start_pos, sz);
+				continue;
+			}
+
+			data.clear();
+			while (sz > 0) {
+				auto limit = std::min(sz, PAGE_SIZE - start_pos);
+				std::copy_n(page_at(pgpos).cbegin() + start_pos, limit, std::back_inserter(data));
+				sz -= limit;
+				start_pos = PAGE_HEADER_SIZE;
+				pgpos += PAGE_SIZE;
+			}
+			read(i, std::as_const(data).data(), data.size());
+		}
+	}
+
+	/// Same as 'place_inner', but the 'sz' bytes are produced by 'write(uint8_t *, std::size_t)' which returns
+	/// whether it succeeded. If they fit in a single page, they are written right inside of the cached page - without
+	/// any intermediate buffer. Returns false if 'write' fails, in which case the contents of the bytes are unspecified.
+	template<typename Writer>
+	requires std::is_invocable_r_v<bool, Writer, uint8_t *, std::size_t>
+	bool place_inner_with(Position pos, std::size_t sz, Writer &&write) {
+		const auto start_pos = pos % PAGE_SIZE;
+		if (start_pos + sz > PAGE_SIZE) {
+			std::vector<uint8_t> data(sz);
+			if (!write(data.data(), sz))
+				return false;
+			place_inner(pos, data);
+			return true;
+		}
+
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		const auto pgpos = page_pos_of(pos);
+		assert(start_pos >= PAGE_HEADER_SIZE);
+		bool written = false;
+		__modify(pgpos, [&](Page &page) {
+			if (page.front() != static_cast<uint8_t>(PageType::Slots))
+				throw BadWrite(fmt::format("cannot inner write to page (@{}) without support for inner operations", pgpos));
+			written = write(page.data() + start_pos, sz);
+		});
+		return written;
+	}
+
 	///
 	/// Properties
 	///
@@ -793,6 +1056,9 @@ private:
 	std::string m_identifier;
 	std::fstream m_disk;
 	mutable std::mutex m_inner_opers_mutex;
+
+	/// Slots pages which are being emptied - no inner allocations are made in them
+	std::unordered_set<Position> m_draining;
 };
 
 template<typename AllocatorPolicy = FreeListAllocator>
@@ -848,6 +1114,16 @@ public:
 			UNREACHABLE
 	}
 
+	/// Modify the page at a given position in place, by calling 'fn(Page &)'.
+	template<typename Fn>
+	requires std::is_invocable_v<Fn, Page &>
+	void modify(const Position pos, Fn &&fn) {
+		std::scoped_lock<std::mutex> _guard{this->m_mutex};
+		// InMemoryPager stores all pages in the cache.
+		[[maybe_unused]] const bool cached = this->m_cache.modify(pos, std::forward<Fn>(fn));
+		assert(cached);
+	}
+
 public:
 	[[nodiscard]] std::string_view identifier() const noexcept { return m_identifier; }
 
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <nop/structure.h>
+
+#include <fmt/core.h>
+
+#include <core/Util.h>
+#include <core/storage/Pager.h>
+
+namespace internal::storage {
+
+/// Codecs of the dynamic values
+/// A codec transforms the encoding of each value stored through the 'IndirectionVector'. Its state is trained once
+/// from a sample of the stored values and persisted along with the tree. A codec provides:
+///  - encode(in, out) and decode(in, out), which replace the contents of 'out';
+///  - train(samples), which prepares the codec for values which look like 'samples';
+///  - a nop structure of the state which needs to be persisted;
+///  - optionally, load(), which is called once the persisted state is read.
+
+/// The values are stored as they are
+struct NoValueCodec {};
+
+/// Compression against a dictionary shared by all values
+/// Short values rarely repeat anything within themselves, but similar values repeat each other - e.g the field names
+/// and the punctuation of JSON documents. The dictionary is built out of the segments of the samples which contain
+/// the most frequent substrings, and each value is encoded as a sequence of literals and back-references which may
+/// reach into the dictionary, as if it were placed right before the value.
+///
+/// A value is encoded as a sequence of
+///  - token (1 byte), the number of literals in its high 4 bits and the length of the match (minus MIN_MATCH) in
+///    its low 4 bits, where 15 means that the rest of the number follows as a varint;
+///  - literals;
+///  - distance of the match (varint), followed by the rest of its length if needed, unless this is the last
+///    sequence, which has no match.
+template<std::size_t DICTIONARY_SIZE = 4_KB>
+class DictionaryCodec {
+	static constexpr std::size_t MIN_MATCH = 4;
+	static constexpr std::size_t MAX_CHAIN = 16;
+	static constexpr std::size_t HASH_BITS = 12;
+	static constexpr std::size_t LOCAL_HASH_BITS = 10;
+	static constexpr int NO_POSITION = -1;
+
+	/// Training
+	static constexpr std::size_t KMER_SIZE = 6;
+	static constexpr std::size_t SEGMENT_SIZE = 64;
+	static constexpr std::size_t MAX_SAMPLES_SIZE = 64 * DICTIONARY_SIZE;
+
+public:
+	DictionaryCodec() { index_dictionary(); }
+
+	/// Index the dictionary which was read
+	void load() { index_dictionary(); }
+
+	void encode(std::span<const uint8_t> in, std::vector<uint8_t> &out) const {
+		out.clear();
+		out.reserve(in.size() + in.size() / 8 + 2);
+
+		std::array<int, 1 << LOCAL_HASH_BITS> local_head;
+		std::ranges::fill(local_head, NO_POSITION);
+		std::vector<int> local_prev(in.size(), NO_POSITION);
+		auto insert_local = [&](const std::size_t pos) {
+			const auto h = hash<LOCAL_HASH_BITS>(in.data() + pos);
+			local_prev[pos] = local_head[h];
+			local_head[h] = static_cast<int>(pos);
+		};
+
+		std::size_t literals_begin = 0;
+		std::size_t i = 0;
+		while (i + MIN_MATCH <= in.size()) {
+			std::size_t best_len = 0;
+			std::size_t best_dist = 0;
+
+			/// Matches in the dictionary
+			auto tries = 0ul;
+			for (int c = m_dict_head[hash<HASH_BITS>(in.data() + i)]; c != NO_POSITION && tries < MAX_CHAIN; c = m_dict_prev[c], ++tries) {
+				const auto len = match_length(m_dictionary.data() + c, m_dictionary.size() - c, in.data() + i, in.size() - i);
+				if (len > best_len) {
+					best_len = len;
+					best_dist = m_dictionary.size() - c + i;
+				}
+			}
+
+			/// Matches earlier in the value
+			tries = 0;
+			for (int c = local_head[hash<LOCAL_HASH_BITS>(in.data() + i)]; c != NO_POSITION && tries < MAX_CHAIN; c = local_prev[c], ++tries) {
+				const auto len = match_length(in.data() + c, in.size() - c, in.data() + i, in.size() - i);
+				if (len > best_len || (len == best_len && len > 0 && i - c < best_dist)) {
+					best_len = len;
+					best_dist = i - c;
+				}
+			}
+
+			insert_local(i);
+			if (best_len < MIN_MATCH) {
+				++i;
+				continue;
+			}
+
+			put_sequence(out, in.subspan(literals_begin, i - literals_begin), best_len - MIN_MATCH);
+			put_varint(out, best_dist);
+			if (best_len - MIN_MATCH >= 15)
+				put_varint(out, best_len - MIN_MATCH - 15);
+			for (std::size_t j = i + 1; j < i + best_len && j + MIN_MATCH <= in.size(); ++j)
+				insert_local(j);
+			i += best_len;
+			literals_begin = i;
+		}
+
+		put_sequence(out, in.subspan(literals_begin), 0);
+	}
+
+	void decode(std::span<const uint8_t> in, std::vector<uint8_t> &out) const {
+		out.clear();
+		std::size_t i = 0;
+		while (i < in.size()) {
+			const auto token = in[i++];
+			auto literals = static_cast<std::size_t>(token >> 4);
+			if (literals == 15)
+				literals += get_varint(in, i);
+			if (literals > in.size() - i)
+				throw BadRead("dictionary codec: literals out of bounds");
+			out.insert(out.end(), in.begin() + i, in.begin() + i + literals);
+			i += literals;
+			if (i == in.size())
+				break;
+
+			auto len = static_cast<std::size_t>(token & 0xF);
+			const auto dist = get_varint(in, i);
+			if (len == 15)
+				len += get_varint(in, i);
+			len += MIN_MATCH;
+			if (dist == 0 || dist > m_dictionary.size() + out.size())
+				throw BadRead(fmt::format("dictionary codec: match distance (={}) out of bounds", dist));
+
+			/// Position of the match in the dictionary followed by the output
+			auto from = m_dictionary.size() + out.size() - dist;
+			for (std::size_t j = 0; j < len; ++j, ++from)
+				out.push_back(from < m_dictionary.size() ? m_dictionary[from] : out[from - m_dictionary.size()]);
+		}
+	}
+
+	/// Build the dictionary out of the segments of the samples which cover the most frequent k-mers
+	/// Each round picks the segment with the largest total frequency of its k-mers, which are then considered
+	/// covered. The best segments are placed at the end of the dictionary, closest to the values.
+	void train(const std::vector<std::vector<uint8_t>> &samples) {
+		std::unordered_map<uint64_t, std::size_t> frequency;
+		std::vector<std::span<const uint8_t>> sampled;
+		std::size_t sampled_size = 0;
+		for (const auto &sample : samples) {
+			if (sample.size() < KMER_SIZE)
+				continue;
+			if (sampled_size + sample.size() > MAX_SAMPLES_SIZE)
+				break;
+			sampled.emplace_back(sample);
+			sampled_size += sample.size();
+
+			/// K-mers are counted once per sample, since a value gains nothing from a repeated one.
+			std::vector<uint64_t> kmers;
+			for (std::size_t p = 0; p + KMER_SIZE <= sample.size(); ++p)
+				kmers.push_back(kmer(sample.data() + p));
+			std::ranges::sort(kmers);
+			const auto [first, last] = std::ranges::unique(kmers);
+			kmers.erase(first, last);
+			for (const auto k : kmers)
+				++frequency[k];
+		}
+
+		std::vector<std::span<const uint8_t>> segments;
+		std::size_t dictionary_size = 0;
+		while (dictionary_size < DICTIONARY_SIZE) {
+			std::size_t best_score = 0;
+			std::span<const uint8_t> best;
+			std::vector<std::size_t> scores;
+			for (const auto sample : sampled) {
+				const auto num_kmers = sample.size() - KMER_SIZE + 1;
+				scores.resize(num_kmers);
+				for (std::size_t p = 0; p < num_kmers; ++p) {
+					const auto it = frequency.find(kmer(sample.data() + p));
+					/// K-mers found in a single sample are not worth keeping.
+					scores[p] = it != frequency.end() && it->second > 1 ? it->second : 0;
+				}
+
+				const auto window = std::min(num_kmers, SEGMENT_SIZE - KMER_SIZE + 1);
+				std::size_t score = 0;
+				for (std::size_t p = 0; p < num_kmers; ++p) {
+					score += scores[p];
+					if (p >= window)
+						score -= scores[p - window];
+					if (p + 1 >= window && score > best_score) {
+						best_score = score;
+						const auto begin = p + 1 - window;
+						best = sample.subspan(begin, std::min(SEGMENT_SIZE, sample.size() - begin));
+					}
+				}
+			}
+			if (best_score == 0)
+				break;
+
+			for (std::size_t p = 0; p + KMER_SIZE <= best.size(); ++p)
+				frequency.erase(kmer(best.data() + p));
+			best = best.first(std::min(best.size(), DICTIONARY_SIZE - dictionary_size));
+			segments.push_back(best);
+			dictionary_size += best.size();
+		}
+
+		m_dictionary.clear();
+		for (const auto segment : segments | std::views::reverse)
+			m_dictionary.insert(m_dictionary.end(), segment.begin(), segment.end());
+		index_dictionary();
+	}
+
+	[[nodiscard]] const std::vector<uint8_t> &dictionary() const noexcept { return m_dictionary; }
+
+private:
+	template<std::size_t BITS>
+	[[nodiscard]] static std::size_t hash(const uint8_t *p) {
+		uint32_t word;
+		std::memcpy(&word, p, sizeof(word));
+		return (word * 2654435761u) >> (32 - BITS);
+	}
+
+	[[nodiscard]] static uint64_t kmer(const uint8_t *p) {
+		uint64_t k = 0;
+		std::memcpy(&k, p, KMER_SIZE);
+		return k;
+	}
+
+	[[nodiscard]] static std::size_t match_length(const uint8_t *lhs, const std::size_t lhs_size, const uint8_t *rhs, const std::size_t rhs_size) {
+		const auto limit = std::min(lhs_size, rhs_size);
+		std::size_t len = 0;
+		while (len < limit && lhs[len] == rhs[len])
+			++len;
+		return len;
+	}
+
+	static void put_varint(std::vector<uint8_t> &out, std::size_t n) {
+		for (; n >= 0x80; n >>= 7)
+			out.push_back(static_cast<uint8_t>(n | 0x80));
+		out.push_back(static_cast<uint8_t>(n));
+	}
+
+	[[nodiscard]] static std::size_t get_varint(std::span<const uint8_t> in, std::size_t &i) {
+		std::size_t n = 0;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			if (i >= in.size())
+				throw BadRead("dictionary codec: truncated varint");
+			const auto byte = in[i++];
+			n |= static_cast<std::size_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return n;
+		}
+		throw BadRead("dictionary codec: malformed varint");
+	}
+
+	/// Emit the token and the literals of a sequence - the distance and the rest of the length of its match follow, if any.
+	static void put_sequence(std::vector<uint8_t> &out, std::span<const uint8_t> literals, const std::size_t match_len) {
+		out.push_back(static_cast<uint8_t>(std::min<std::size_t>(literals.size(), 15) << 4 | std::min<std::size_t>(match_len, 15)));
+		if (literals.size() >= 15)
+			put_varint(out, literals.size() - 15);
+		out.insert(out.end(), literals.begin(), literals.end());
+	}
+
+	void index_dictionary() {
+		m_dict_head.assign(1 << HASH_BITS, NO_POSITION);
+		m_dict_prev.assign(m_dictionary.size(), NO_POSITION);
+		for (std::size_t p = 0; p + MIN_MATCH <= m_dictionary.size(); ++p) {
+			const auto h = hash<HASH_BITS>(m_dictionary.data() + p);
+			m_dict_prev[p] = m_dict_head[h];
+			m_dict_head[h] = static_cast<int>(p);
+		}
+	}
+
+private:
+	std::vector<uint8_t> m_dictionary;
+
+	/// Chains of the positions in the dictionary with the same hash, the latest one first
+	std::vector<int> m_dict_head;
+	std::vector<int> m_dict_prev;
+
+	NOP_STRUCTURE(DictionaryCodec, m_dictionary);
+};
+
+}// namespace internal::storage
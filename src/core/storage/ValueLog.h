@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nop/serializer.h>
+#include <nop/structure.h>
+#include <nop/utility/stream_reader.h>
+#include <nop/utility/stream_writer.h>
+
+#include <fmt/core.h>
+
+#include <core/Util.h>
+#include <core/storage/Pager.h>
+
+namespace internal::storage {
+
+/// Append-only log of values (key-value separation)
+/// Values are appended to the newest ("head") segment, each one preceded by a record header which names the owner
+/// of the value - the id of the slot which refers to it. Freeing a value only updates the accounting of its
+/// segment. Once enough of a segment is garbage, 'collect_garbage' appends the values which are still live to the
+/// head, lets their owners know about their new positions and drops the segment.
+/// The position of a value is the id of its segment in the high 32 bits and its offset in the segment in the low ones.
+class ValueLog {
+	struct RecordHeader {
+		uint64_t owner;
+		uint64_t size;
+	};
+
+	static constexpr std::size_t RECORD_HEADER_SIZE = sizeof(RecordHeader);
+
+public:
+	/// Maximum number of segment files which are kept open at once
+	/// The file of the head segment stays open all the time, the rest are closed in least recently used order.
+	static constexpr std::size_t MAX_OPEN_SEGMENTS = 8;
+
+	/// Number of bytes in a segment, both of the values and their headers
+	struct SegmentUsage {
+		std::size_t total = 0;
+		std::size_t live = 0;
+
+		NOP_STRUCTURE(SegmentUsage, total, live);
+	};
+
+	explicit ValueLog(std::string identifier, const std::size_t segment_size = 4_MB, const double gc_ratio = 0.5)
+	    : m_identifier{std::move(identifier)}, m_segment_size{segment_size}, m_gc_ratio{gc_ratio} {}
+
+	ValueLog(const ValueLog &) = delete;
+	ValueLog &operator=(const ValueLog &) = delete;
+
+	///
+	/// Operations API
+	///
+
+	/// Append 'data', owned by 'owner', to the head segment
+	[[nodiscard]] Position append(const uint64_t owner, std::span<const uint8_t> data) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		return __append(owner, data);
+	}
+
+	/// Read the 'sz' bytes of the value placed at 'pos'
+	[[nodiscard]] std::vector<uint8_t> read(const Position pos, const std::size_t sz) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		std::vector<uint8_t> data(sz);
+		__read(pos, data);
+		return data;
+	}
+
+	/// Read many values at once
+	/// Same as 'Pager::get_inner_many' - 'read(i, data, sz)' is called for each of the ranges, which are expected
+	/// to be sorted by their position, so that the segments are read sequentially.
+	void read_many(std::span<const std::pair<Position, std::size_t>> ranges, auto &&read) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		std::vector<uint8_t> data;
+		for (std::size_t i = 0; i < ranges.size(); ++i) {
+			const auto [pos, sz] = ranges[i];
+			data.resize(sz);
+			__read(pos, data);
+			read(i, static_cast<const uint8_t *>(data.data()), sz);
+		}
+	}
+
+	/// Mark the value at 'pos' as garbage
+	void free(const Position pos, const std::size_t sz) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		if (auto it = m_segments.find(segment_of(pos)); it != m_segments.end())
+			it->second.live -= std::min(it->second.live, RECORD_HEADER_SIZE + sz);
+	}
+
+	/// Rewrite the segments which are mostly garbage
+	/// 'is_live(owner, pos)' tells whether the value at 'pos' is still referenced by its owner, and
+	/// 'relocate(owner, new_pos)' updates the reference once the value has been moved.
+	/// The files of the collected segments are removed on the next 'save', so that the log stays consistent with
+	/// the last saved references until then. Returns the number of collected segments.
+	std::size_t collect_garbage(auto &&is_live, auto &&relocate) {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		if (m_segments.empty())
+			return 0;
+
+		const auto head = m_segments.rbegin()->first;
+		std::vector<uint64_t> victims;
+		for (const auto &[id, usage] : m_segments)
+			if (id != head && static_cast<double>(usage.total - usage.live) >= m_gc_ratio * static_cast<double>(usage.total))
+				victims.push_back(id);
+
+		std::vector<uint8_t> data;
+		for (const auto id : victims) {
+			const auto total = m_segments.at(id).total;
+			for (std::size_t offset = 0; offset < total;) {
+				RecordHeader header;
+				__read_at(id, offset, {reinterpret_cast<uint8_t *>(&header), RECORD_HEADER_SIZE});
+				const auto pos = position_of(id, offset + RECORD_HEADER_SIZE);
+				if (is_live(header.owner, pos)) {
+					data.resize(header.size);
+					__read(pos, data);
+					relocate(header.owner, __append(header.owner, data));
+				}
+				offset += RECORD_HEADER_SIZE + header.size;
+			}
+			m_segments.erase(id);
+			std::erase_if(m_files, [id](const auto &file) { return file.first == id; });
+			m_retired.push_back(id);
+		}
+
+		return victims.size();
+	}
+
+	///
+	/// Persistence
+	///
+
+	void load() {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		fmt::print("[value-log] loading '{}'\n", m_identifier);
+		nop::Deserializer<nop::StreamReader<std::ifstream>> deserializer{m_identifier};
+		if (!deserializer.Read(this))
+			throw BadRead("deserializer fails reading value log");
+		m_files.clear();
+	}
+
+	void save() {
+		std::scoped_lock<std::mutex> _guard{m_mutex};
+		fmt::print("[value-log] saving '{}'\n", m_identifier);
+		for (auto &[_, file] : m_files)
+			file.flush();
+		nop::Serializer<nop::StreamWriter<std::ofstream>> serializer{m_identifier, std::ios::trunc};
+		if (!serializer.Write(*this))
+			throw BadWrite("serializer fails writing value log");
+
+		for (const auto id : m_retired)
+			fs::remove(segment_name(id));
+		m_retired.clear();
+	}
+
+	///
+	/// Properties
+	///
+
+	/// Number of bytes in all segments
+	[[nodiscard]] std::size_t size() const noexcept {
+		std::size_t total = 0;
+		for (const auto &[_, usage] : m_segments)
+			total += usage.total;
+		return total;
+	}
+
+	/// Number of bytes in all segments which are still referenced
+	[[nodiscard]] std::size_t live_size() const noexcept {
+		std::size_t live = 0;
+		for (const auto &[_, usage] : m_segments)
+			live += usage.live;
+		return live;
+	}
+
+	[[nodiscard]] const std::map<uint64_t, SegmentUsage> &segments() const noexcept { return m_segments; }
+
+	[[nodiscard]] std::size_t num_open_segments() const noexcept { return m_files.size(); }
+
+private:
+	[[nodiscard]] static constexpr uint64_t segment_of(const Position pos) { return pos >> 32; }
+	[[nodiscard]] static constexpr std::size_t offset_of(const Position pos) { return pos & 0xFFFF'FFFF; }
+	[[nodiscard]] static constexpr Position position_of(const uint64_t segment, const std::size_t offset) { return (segment << 32) | offset; }
+
+	[[nodiscard]] std::string segment_name(const uint64_t id) const { return fmt::format("{}-{}", m_identifier, id); }
+
+	/// The returned file stays valid until the next call
+	std::fstream &segment_file(const uint64_t id) {
+		if (auto it = std::ranges::find(m_files, id, &OpenSegment::first); it != m_files.end()) {
+			m_files.splice(m_files.begin(), m_files, it);
+			return m_files.front().second;
+		}
+
+		if (m_files.size() >= MAX_OPEN_SEGMENTS) {
+			const auto head = m_segments.empty() ? id : m_segments.rbegin()->first;
+			auto victim = std::find_if(m_files.rbegin(), m_files.rend(), [head](const OpenSegment &file) { return file.first != head; });
+			m_files.erase(std::next(victim).base());
+		}
+
+		const auto name = segment_name(id);
+		auto mode = std::ios::in | std::ios::out | std::ios::binary;
+		if (!fs::exists(name))
+			mode |= std::ios::trunc;
+		auto &file = m_files.emplace_front(id, std::fstream{}).second;
+		file.open(name, mode);
+		if (!file) {
+			m_files.pop_front();
+			throw BadRead(fmt::format("cannot open value log segment '{}'", name));
+		}
+		return file;
+	}
+
+	/// A new segment is started once the head one would outgrow 'm_segment_size'. Values larger than that are
+	/// placed in a segment of their own.
+	Position __append(const uint64_t owner, std::span<const uint8_t> data) {
+		const auto record_size = RECORD_HEADER_SIZE + data.size();
+		if (m_segments.empty() || (m_segments.rbegin()->second.total > 0 && m_segments.rbegin()->second.total + record_size > m_segment_size))
+			m_segments.emplace(m_next_segment++, SegmentUsage{});
+
+		auto &[id, usage] = *m_segments.rbegin();
+		const RecordHeader header{.owner = owner, .size = data.size()};
+		auto &file = segment_file(id);
+		file.seekp(static_cast<std::streamoff>(usage.total));
+		file.write(reinterpret_cast<const char *>(&header), RECORD_HEADER_SIZE);
+		file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+		if (!file)
+			throw BadWrite(fmt::format("cannot append to value log segment '{}'", segment_name(id)));
+
+		const auto pos = position_of(id, usage.total + RECORD_HEADER_SIZE);
+		usage.total += record_size;
+		usage.live += record_size;
+		return pos;
+	}
+
+	void __read_at(const uint64_t id, const std::size_t offset, std::span<uint8_t> data) {
+		if (!m_segments.contains(id) || offset + data.size() > m_segments.at(id).total)
+			throw BadRead(fmt::format("value log has no data at (segment = {}, offset = {})", id, offset));
+		auto &file = segment_file(id);
+		file.seekg(static_cast<std::streamoff>(offset));
+		file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+		if (!file)
+			throw BadRead(fmt::format("cannot read value log segment '{}'", segment_name(id)));
+	}
+
+	void __read(const Position pos, std::span<uint8_t> data) {
+		__read_at(segment_of(pos), offset_of(pos), data);
+	}
+
+private:
+	std::string m_identifier;
+	std::size_t m_segment_size;
+	double m_gc_ratio;
+
+	std::map<uint64_t, SegmentUsage> m_segments;
+	uint64_t m_next_segment = 0;
+
+	/// Segments which have been collected but whose files are still needed until the next save
+	std::vector<uint64_t> m_retired;
+
+	/// Open segment files, the most recently used first
+	using OpenSegment = std::pair<uint64_t, std::fstream>;
+	std::list<OpenSegment> m_files;
+	std::mutex m_mutex;
+
+	NOP_STRUCTURE(ValueLog, m_segments, m_next_segment);
+};
+
+}// namespace internal::storage
@@ -1,7 +1,9 @@
 #include <filesystem>
+#include <forward_list>
 #include <map>
 #include <ranges>
 #include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -62,6 +64,61 @@ struct DoubleToVectorOfStrings : Config {
 	static inline constexpr bool DYN_ENTRIES = true;
 };
 
+struct IntToIntDeltaChains : Config {
+	static inline constexpr int LEAF_DELTA_CHAIN = 8;
+};
+
+struct IntToStringDeltaChains : IntToString {
+	static inline constexpr int LEAF_DELTA_CHAIN = 8;
+};
+
+struct LongToInt : Config {
+	using Key = long;
+	using Ref = long;
+};
+
+struct LongToIntPackedKeys : LongToInt {
+	static inline constexpr bool PACK_LEAF_KEYS = true;
+};
+
+template<>
+struct internal::storage::btree::Columns<person> {
+	static constexpr auto fields = std::make_tuple(&person::name, &person::age, &person::email);
+};
+
+struct IntToPersonColumnar : Config {
+	using Val = person;
+	using RealVal = person;
+	static inline constexpr bool COLUMNAR_LEAVES = true;
+};
+
+struct IntToStringValueLog : IntToString {
+	static inline constexpr bool VALUE_LOG = true;
+	static inline constexpr std::size_t VALUE_LOG_SEGMENT_SIZE = 4_KB;
+};
+
+struct IntToStringCompressed : IntToStringValueLog {
+	using ValueCodec = storage::DictionaryCodec<>;
+};
+
+struct IntToStringCached : IntToString {
+	static inline constexpr std::size_t VALUE_CACHE_SIZE = 4_KB;
+};
+
+struct IntToStringTTL : IntToString {
+	static inline constexpr bool TTL_ENTRIES = true;
+};
+
+struct IntToIntShortTTL : Config {
+	static inline constexpr bool TTL_ENTRIES = true;
+	static inline constexpr std::chrono::milliseconds ENTRY_TTL{50};
+};
+
+struct IntToIntShortTTLNarrow : IntToIntShortTTL {
+	static inline constexpr int BRANCHING_FACTOR_LEAF = 8;
+	static inline constexpr int BRANCHING_FACTOR_BRANCH = 4;
+};
+
 ///
 /// Utility functions
 ///
@@ -286,6 +343,61 @@ TEST_CASE("Btree bulk operations", "[btree]") {
 		}
 		REQUIRE(bpt.empty());
 	}
+
+	SECTION("Bulk insertion marks and updates") {
+		Btree<Tree23> bpt("/tmp/eugene-tests/btree-bulk-insertion/marks-and-updates");
+		bpt.insert_many(std::vector<Btree<Tree23>::Entry>{e(7), e(8), e(10), e(28)});
+
+		const auto marks = bpt.insert_many(std::vector<Btree<Tree23>::Entry>{e(5), e(8), e(9), e(28), e(30)});
+		REQUIRE(marks.size() == 5);
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(marks[0]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedNothing>(marks[1]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(marks[2]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedNothing>(marks[3]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(marks[4]));
+		REQUIRE(bpt.size() == 7);
+
+		const auto update_marks = bpt.insert_many(std::vector<Btree<Tree23>::Entry>{{.key = 8, .val = 80}, {.key = 11, .val = 110}}, ActionOnKeyPresent::SubmitChange);
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(update_marks[0]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedNothing>(update_marks[1]));
+		REQUIRE(bpt.size() == 7);
+		REQUIRE(bpt.get(8).value() == 80);
+		REQUIRE_FALSE(bpt.contains(11));
+
+		/// Marks of a range which is not random access are aligned as well
+		const std::forward_list<Btree<Tree23>::Entry> forward{e(1), e(5), e(6), e(40)};
+		const auto forward_marks = bpt.insert_many(forward);
+		REQUIRE(forward_marks.size() == 4);
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(forward_marks[0]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedNothing>(forward_marks[1]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(forward_marks[2]));
+		REQUIRE(std::holds_alternative<Btree<Tree23>::InsertedEntry>(forward_marks[3]));
+		REQUIRE(bpt.size() == 10);
+	}
+
+	SECTION("Moving and emplacing dynamic entries") {
+		Btree<IntToString> bpt("/tmp/eugene-tests/btree-bulk-insertion/move-and-emplace");
+		std::string val(64, 'x');
+		REQUIRE(std::holds_alternative<Btree<IntToString>::InsertedEntry>(bpt.insert(1, std::move(val))));
+		REQUIRE(std::holds_alternative<Btree<IntToString>::InsertedEntry>(bpt.emplace(2, 16, 'y')));
+		REQUIRE(std::holds_alternative<Btree<IntToString>::InsertedNothing>(bpt.emplace(2, 16, 'z')));
+		REQUIRE(bpt.get(1).value() == std::string(64, 'x'));
+		REQUIRE(bpt.get(2).value() == std::string(16, 'y'));
+
+		REQUIRE(std::holds_alternative<Btree<IntToString>::InsertedEntry>(bpt.update(2, std::string(8, 'z'))));
+		REQUIRE(bpt.size() == 2);
+		REQUIRE(bpt.get(2).value() == std::string(8, 'z'));
+
+		std::vector<Btree<IntToString>::Entry> bulk;
+		for (int i = 3; i < 100; ++i)
+			bulk.push_back({.key = i, .val = std::to_string(i)});
+		const auto marks = bpt.insert_many(std::move(bulk));
+		REQUIRE(marks.size() == 97);
+		REQUIRE(bpt.size() == 99);
+		for (int i = 3; i < 100; ++i)
+			REQUIRE(bpt.get(i).value() == std::to_string(i));
+		REQUIRE(bpt.get(1).value() == std::string(64, 'x'));
+	}
 }
 
 TEST_CASE("Btree persistence", "[btree]") {
@@ -374,6 +486,186 @@ TEST_CASE("Btree configs") {
 		}
 	}
 
+	SECTION("Leaf delta chains") {
+		Btree<IntToIntDeltaChains> bpt{"/tmp/eugene-tests/btree-configs/leaf-delta-chains"};
+		auto backup = fill_tree_with_random_items(bpt, 1000);
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		for (auto &[key, val] : backup) {
+			if (random_item<bool>())
+				continue;
+			val = key;
+			REQUIRE(std::holds_alternative<Btree<IntToIntDeltaChains>::InsertedEntry>(bpt.update(key, key)));
+		}
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		Btree<IntToStringDeltaChains> dyn_bpt{"/tmp/eugene-tests/btree-configs/leaf-delta-chains-dyn"};
+		for (int i = 0; i < 200; ++i)
+			dyn_bpt.insert(i, std::to_string(i));
+		for (int i = 0; i < 200; i += 3)
+			dyn_bpt.update(i, std::to_string(-i));
+		for (int i = 0; i < 200; ++i)
+			REQUIRE(dyn_bpt.get(i).value() == std::to_string(i % 3 ? i : -i));
+	}
+
+	SECTION("Packed leaf keys") {
+		Btree<LongToIntPackedKeys> bpt{"/tmp/eugene-tests/btree-configs/packed-leaf-keys"};
+		Btree<LongToInt> unpacked{"/tmp/eugene-tests/btree-configs/packed-leaf-keys-unpacked"};
+		REQUIRE(bpt.max_num_records_leaf() > unpacked.max_num_records_leaf());
+
+		/// Dense keys fill up leaves up to their maximum number of entries
+		for (long key = 1'000'000; key < 1'005'000; ++key)
+			bpt.insert(key, static_cast<int>(key % 1000));
+		REQUIRE(bpt.size() == 5000);
+		for (long key = 1'000'000; key < 1'005'000; ++key)
+			REQUIRE(bpt.get(key).value() == key % 1000);
+
+		/// Sparse keys make leaves overflow their page earlier
+		auto backup = fill_tree_with_random_items(bpt, 2000);
+		for (long key = 1'000'000; key < 1'005'000; ++key)
+			backup.emplace(key, static_cast<int>(key % 1000));
+		check_for_tree_backup_mismatch(bpt, backup);
+	}
+
+	SECTION("Columnar leaves") {
+		Btree<IntToPersonColumnar> bpt{"/tmp/eugene-tests/btree-configs/columnar-leaves"};
+		auto backup = fill_tree_with_random_items(bpt, 1000);
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		std::vector<std::pair<int, int>> ages;
+		for (const auto &[key, age] : bpt.get_all_in_column<&person::age>())
+			ages.emplace_back(key, age);
+		REQUIRE(ages.size() == backup.size());
+		REQUIRE(std::ranges::equal(ages, backup, [](const auto &lhs, const auto &rhs) { return lhs.first == rhs.first && lhs.second == rhs.second.age; }));
+
+		const int median_age = backup.begin()->second.age + 500;
+		std::size_t num_older = 0;
+		for (const auto &[key, age] : bpt.get_all_in_column_filtered<&person::age>([median_age](int age) { return age >= median_age; })) {
+			REQUIRE(backup.at(key).age == age);
+			REQUIRE(age >= median_age);
+			++num_older;
+		}
+		REQUIRE(num_older == static_cast<std::size_t>(std::ranges::count_if(backup, [median_age](const auto &entry) { return entry.second.age >= median_age; })));
+	}
+
+	SECTION("Entry expiration") {
+		using namespace std::chrono_literals;
+		using Tree = Btree<IntToStringTTL>;
+		Tree bpt{"/tmp/eugene-tests/btree-configs/entry-expiration"};
+
+		static constexpr int limit = 1000;
+		for (int i = 0; i < limit; ++i) {
+			if (i % 3 == 0) {
+				bpt.insert(i, std::to_string(i), 50ms);
+				REQUIRE(bpt.contains(i));
+			} else {
+				bpt.insert(i, std::to_string(i));
+			}
+		}
+		std::this_thread::sleep_for(100ms);
+
+		/// Expired entries are filtered out by the reads, but still occupy space.
+		REQUIRE(bpt.size() == limit);
+		for (int i = 0; i < limit; ++i) {
+			REQUIRE(bpt.contains(i) == (i % 3 != 0));
+			REQUIRE(bpt.get(i).has_value() == (i % 3 != 0));
+		}
+		REQUIRE(bpt.get_min_entry()->key == 1);
+		REQUIRE(bpt.get_max_entry()->key == limit - 2);
+		std::size_t num_live = 0;
+		for ([[maybe_unused]] const auto &entry : bpt.get_all_entries())
+			++num_live;
+		REQUIRE(num_live == limit - (limit + 2) / 3);
+
+		/// Expired keys cannot be updated, but can be inserted again.
+		REQUIRE(std::holds_alternative<Tree::InsertedNothing>(bpt.update(3, "three")));
+		REQUIRE(std::holds_alternative<Tree::InsertedEntry>(bpt.insert(3, "three")));
+		REQUIRE(std::holds_alternative<Tree::RemovedNothing>(bpt.remove(6)));
+		REQUIRE(bpt.get(3).value() == "three");
+
+		const auto num_purged = bpt.purge_expired();
+		REQUIRE(num_purged == (limit + 2) / 3 - 2);
+		REQUIRE(bpt.size() == limit - num_purged - 1);
+		REQUIRE(bpt.purge_expired() == 0);
+		for (int i = 0; i < limit; ++i)
+			REQUIRE(bpt.get(i).has_value() == (i % 3 != 0 || i == 3));
+
+		Btree<IntToIntShortTTL> short_bpt{"/tmp/eugene-tests/btree-configs/entry-expiration-default"};
+		for (int i = 0; i < limit; ++i)
+			short_bpt.insert(i, i);
+		short_bpt.insert(limit, limit, 1h);
+		std::this_thread::sleep_for(100ms);
+		REQUIRE(short_bpt.get_min_entry().has_value());
+		REQUIRE(short_bpt.get_min_entry()->key == limit);
+		REQUIRE(short_bpt.purge_expired() == limit);
+		REQUIRE(short_bpt.size() == 1);
+		REQUIRE(short_bpt.get(limit).value() == limit);
+
+		/// The freed leaves are unlinked from the leaf chain, the tree keeps accepting entries.
+		for (int i = 0; i < limit; i += 2)
+			short_bpt.insert(i, i);
+		std::size_t num_entries = 0;
+		for ([[maybe_unused]] const auto &entry : short_bpt.get_all_entries())
+			++num_entries;
+		REQUIRE(num_entries == limit / 2 + 1);
+		REQUIRE(short_bpt.get_min_entry()->key == 0);
+		REQUIRE(short_bpt.get(limit - 2).value() == limit - 2);
+	}
+
+	SECTION("Purging whole subtrees") {
+		using namespace std::chrono_literals;
+		static constexpr int limit = 400;
+		auto check_live = [](auto &bpt, const int min, const int max) {
+			REQUIRE(bpt.size() == static_cast<std::size_t>(max - min + 1));
+			REQUIRE(bpt.get_min_entry()->key == min);
+			REQUIRE(bpt.get_max_entry()->key == max);
+			int expected = min;
+			for (const auto &entry : bpt.get_all_entries())
+				REQUIRE(entry.key == expected++);
+			REQUIRE(expected == max + 1);
+		};
+
+		for (const bool lower_expire : {true, false}) {
+			Btree<IntToIntShortTTLNarrow> bpt{"/tmp/eugene-tests/btree-configs/entry-expiration-subtrees"};
+			for (int i = 0; i < limit; ++i) {
+				if ((i < limit / 2) == lower_expire)
+					bpt.insert(i, i);
+				else
+					bpt.insert(i, i, 1h);
+			}
+			REQUIRE(bpt.depth() >= 3);
+			std::this_thread::sleep_for(100ms);
+
+			const int min = lower_expire ? limit / 2 : 0;
+			const int max = lower_expire ? limit - 1 : limit / 2 - 1;
+			/// Expired corner entries are skipped before the purge as well.
+			REQUIRE(bpt.get_min_entry()->key == min);
+			REQUIRE(bpt.get_max_entry()->key == max);
+
+			REQUIRE(bpt.purge_expired() == limit / 2);
+			check_live(bpt, min, max);
+			for (int i = 0; i < limit; ++i)
+				REQUIRE(bpt.get(i).has_value() == (i >= min && i <= max));
+
+			/// The rebalanced tree keeps accepting entries.
+			for (int i = 0; i < limit; ++i)
+				bpt.insert(i, i, 1h);
+			check_live(bpt, 0, limit - 1);
+		}
+
+		/// All entries expire
+		Btree<IntToIntShortTTLNarrow> bpt{"/tmp/eugene-tests/btree-configs/entry-expiration-all"};
+		for (int i = 0; i < limit; ++i)
+			bpt.insert(i, i);
+		std::this_thread::sleep_for(100ms);
+		REQUIRE(bpt.purge_expired() == limit);
+		REQUIRE(bpt.depth() == 1);
+		REQUIRE(!bpt.get_min_entry().has_value());
+		for (int i = 0; i < limit; ++i)
+			bpt.insert(i, i, 1h);
+		check_live(bpt, 0, limit - 1);
+	}
+
 	SECTION("User-defined types") {
 		Btree<SmallstrToPerson> bpt{"/tmp/eugene-tests/btree-configs/aggregate-types"};
 
@@ -466,5 +758,178 @@ TEST_CASE("Btree dyn entries") {
 		}
 
 		check_for_tree_backup_mismatch(bpt, backup);
+		bpt.save();
+
+		/// The slot table, along with its free slots, is read back lazily.
+		Tree reloaded{"/tmp/eugene-tests/btree-dyn/strings", ActionOnConstruction::Load};
+		const auto num_slots = reloaded.ind_vector().num_slots();
+		REQUIRE(num_slots == bpt.ind_vector().num_slots());
+		check_for_tree_backup_mismatch(reloaded, backup);
+
+		/// Slots freed by the removals are reused, the slot table does not grow.
+		while (backup.size() != 1000) {
+			const auto key = random_item<int>();
+			const auto val = random_item<std::string>();
+			if (std::holds_alternative<Tree::InsertedEntry>(reloaded.insert(key, val)))
+				backup.emplace(key, val);
+		}
+		REQUIRE(reloaded.ind_vector().num_slots() == num_slots);
+		check_for_tree_backup_mismatch(reloaded, backup);
+
+		/// Scans fetch the values of each leaf in a batch
+		std::vector<std::pair<int, std::string>> scanned;
+		for (const auto &[key, val] : reloaded.get_all_entries())
+			scanned.emplace_back(key, val);
+		REQUIRE(std::ranges::equal(scanned, backup, [](const auto &lhs, const auto &rhs) { return lhs.first == rhs.first && lhs.second == rhs.second; }));
+	}
+
+	SECTION("Value log") {
+		using Tree = Btree<IntToStringValueLog>;
+		Tree bpt{"/tmp/eugene-tests/btree-dyn/vlog", ActionOnConstruction::Bare};
+		auto backup = fill_tree_with_random_items(bpt, 1000);
+
+		/// Overwriting and removing values leaves garbage behind in the log.
+		for (auto i = 0ul; i < 250; ++i) {
+			const auto random_key = random_key_of_map(backup);
+			REQUIRE(std::holds_alternative<Tree::RemovedVal>(bpt.remove(random_key)));
+			backup.erase(random_key);
+		}
+		for (auto &[key, val] : backup) {
+			val = random_item<std::string>();
+			bpt.update(key, val);
+		}
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		const auto &log = bpt.ind_vector().value_log();
+		/// Only a few of the segment files are kept open.
+		REQUIRE(log.segments().size() > storage::ValueLog::MAX_OPEN_SEGMENTS);
+		REQUIRE(log.num_open_segments() <= storage::ValueLog::MAX_OPEN_SEGMENTS);
+		const auto size_before = log.size();
+		REQUIRE(log.live_size() < size_before);
+		REQUIRE(bpt.collect_garbage() > 0);
+		REQUIRE(log.size() < size_before);
+		for (const auto &[id, usage] : log.segments())
+			if (id != log.segments().rbegin()->first)
+				REQUIRE(usage.total - usage.live < usage.total * IntToStringValueLog::VALUE_LOG_GC_RATIO);
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		bpt.save();
+		Tree reloaded{"/tmp/eugene-tests/btree-dyn/vlog", ActionOnConstruction::Load};
+		check_for_tree_backup_mismatch(reloaded, backup);
+	}
+
+	SECTION("Value compression") {
+		using Tree = Btree<IntToStringCompressed>;
+		auto json_value = [](const int key) {
+			return fmt::format(R"({{"id": {}, "name": "user-{}", "email": "user{}@example.com", "roles": ["reader"], "active": {}}})",
+			                   key, random_item<long>() % 100000, key, key % 2 == 0);
+		};
+
+		auto backup = [&] {
+			Tree bpt{"/tmp/eugene-tests/btree-dyn/compressed", ActionOnConstruction::Bare};
+			std::map<int, std::string> backup;
+			while (backup.size() != 1000) {
+				const auto key = random_item<int>();
+				const auto val = json_value(key);
+				if (std::holds_alternative<Tree::InsertedEntry>(bpt.insert(key, val)))
+					backup.emplace(key, val);
+			}
+			const auto untrained_size = bpt.ind_vector().value_log().live_size();
+
+			/// Training re-encodes the values stored so far.
+			bpt.train_value_codec(200);
+			REQUIRE(bpt.ind_vector().value_log().live_size() < untrained_size / 2);
+			check_for_tree_backup_mismatch(bpt, backup);
+
+			/// Values which do not look like the samples still make it through.
+			for (auto i = 0; i < 100; ++i) {
+				const auto key = random_item<int>();
+				const auto val = random_item<std::string>();
+				if (std::holds_alternative<Tree::InsertedEntry>(bpt.insert(key, val)))
+					backup.emplace(key, val);
+			}
+			check_for_tree_backup_mismatch(bpt, backup);
+			bpt.save();
+			return backup;
+		}();
+
+		/// The trained dictionary is stored along with the tree.
+		Tree bpt{"/tmp/eugene-tests/btree-dyn/compressed", ActionOnConstruction::Load};
+		check_for_tree_backup_mismatch(bpt, backup);
+	}
+
+	SECTION("Decoded-value cache") {
+		using Tree = Btree<IntToStringCached>;
+		Tree bpt{"/tmp/eugene-tests/btree-dyn/cached", ActionOnConstruction::Bare};
+		auto backup = fill_tree_with_random_items(bpt, 1000);
+		check_for_tree_backup_mismatch(bpt, backup);
+		check_for_tree_backup_mismatch(bpt, backup);
+		REQUIRE(bpt.ind_vector().value_cache().used() > 0);
+		REQUIRE(bpt.ind_vector().value_cache().used() <= IntToStringCached::VALUE_CACHE_SIZE);
+
+		/// Cached values are dropped once they change.
+		for (auto i = 0ul; i < 200; ++i) {
+			const auto random_key = random_key_of_map(backup);
+			REQUIRE(bpt.get(random_key).value() == backup.at(random_key));
+			if (i % 2 == 0) {
+				const auto val = random_item<std::string>();
+				bpt.update(random_key, val);
+				backup[random_key] = val;
+			} else {
+				REQUIRE(std::holds_alternative<Tree::RemovedVal>(bpt.remove(random_key)));
+				REQUIRE(!bpt.get(random_key).has_value());
+				backup.erase(random_key);
+			}
+		}
+
+		/// Slots freed by the removals are reused for different values.
+		while (backup.size() != 1000) {
+			const auto key = random_item<int>();
+			const auto val = random_item<std::string>();
+			if (std::holds_alternative<Tree::InsertedEntry>(bpt.insert(key, val)))
+				backup.emplace(key, val);
+		}
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		/// A value read before the slot was replaced is not cached after it.
+		storage::DecodedValueCache<std::string> cache{1_KB};
+		const auto generation = cache.generation();
+		cache.erase(1);
+		cache.place(1, "stale", generation);
+		REQUIRE(!cache.get(1).has_value());
+		cache.place(1, "fresh", cache.generation());
+		REQUIRE(cache.get(1).value() == "fresh");
+	}
+
+	SECTION("Compaction") {
+		using Tree = Btree<IntToString>;
+		Tree bpt{"/tmp/eugene-tests/btree-dyn/compacted", ActionOnConstruction::Bare};
+		auto backup = fill_tree_with_random_items(bpt, 2000);
+		for (auto i = 0ul; i < 1600; ++i) {
+			const auto random_key = random_key_of_map(backup);
+			REQUIRE(std::holds_alternative<Tree::RemovedVal>(bpt.remove(random_key)));
+			backup.erase(random_key);
+		}
+		const auto before = bpt.ind_vector().fragmentation_report();
+
+		/// The pass takes several calls and the tree stays usable in between.
+		auto calls = 0ul;
+		while (!bpt.compact_values(4_KB)) {
+			++calls;
+			const auto key = random_item<int>();
+			const auto val = random_item<std::string>();
+			if (std::holds_alternative<Tree::InsertedEntry>(bpt.insert(key, val)))
+				backup.emplace(key, val);
+		}
+		REQUIRE(calls > 1);
+		check_for_tree_backup_mismatch(bpt, backup);
+
+		const auto after = bpt.ind_vector().fragmentation_report();
+		REQUIRE(after.slots_pages < before.slots_pages);
+		REQUIRE(after.live_bytes >= before.live_bytes);
+
+		bpt.save();
+		Tree loaded{"/tmp/eugene-tests/btree-dyn/compacted", ActionOnConstruction::Load};
+		check_for_tree_backup_mismatch(loaded, backup);
 	}
 }
@@ -7,6 +7,7 @@
 #include <exception>
 #include <fstream>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <ranges>
 #include <sstream>
@@ -92,6 +93,7 @@ class Btree {
 
 	using Ref = typename Config::Ref;
 	using Nod = Node<Config>;
+	using Expiry = typename Nod::Expiry;
 
 	using PagerAllocatorPolicy = typename Config::PageAllocatorPolicy;
 	using PagerEvictionPolicy = typename Config::PageEvictionPolicy;
@@ -161,7 +163,8 @@ public:
 	struct InsertedNothing {};
 	using InsertionReturnMark = std::variant<InsertedEntry, InsertedNothing>;
 	/// The bulk version of `InsertionReturnMark`
-	using ManyInsertionReturnMarks = std::unordered_map<Key, InsertionReturnMark>;
+	/// Aligned with the bulk it was produced for, i.e the i-th mark describes the i-th entry.
+	using ManyInsertionReturnMarks = std::vector<InsertionReturnMark>;
 
 	/// Insertion tree is an in-memory instance of a Btree created during bulk-insertion
 	/// following the algorithm implemented as 'insert_many()'. Check its definiton for
@@ -206,6 +209,8 @@ private:
 	[[nodiscard]] constexpr bool is_node_over(const Nod &node) {
 		if (node.is_branch())
 			return node.is_over(__max_num_records_branch());
+		if constexpr (Nod::PACKED_KEYS)
+			return node.is_over(__max_num_records_leaf()) || !node.fits_in_page();
 		return node.is_over(__max_num_records_leaf());
 	}
 
@@ -220,6 +225,10 @@ private:
 	[[nodiscard]] constexpr auto node_split(Nod &node, const SplitBias bias) {
 		if (node.is_branch())
 			return node.split(__max_num_records_branch(), bias);
+		/// Leaves with packed keys may overflow their page before reaching the maximum number of entries,
+		/// in which case there is no "full" node to lean towards.
+		if (Nod::PACKED_KEYS && !node.is_over(__max_num_records_leaf()))
+			return node.split(__max_num_records_leaf(), SplitBias::DistributeEvenly);
 		return node.split(__max_num_records_leaf(), bias);
 	}
 
@@ -266,6 +275,7 @@ private:
 	/// is provided to the called. 'key_expected_pos' contains the index where the key should be positioned and
 	/// 'key_is_present' is a flag denoting whether that is actually the case. If an error occurs during traversal,
 	/// throw a 'BadTreeSearch' with a descriptive message. It gets called by both 'contains()' and 'get()'.
+	/// With TTL entries, 'key_is_expired' denotes that the key is present, but its entry has already expired.
 	///
 	/// Contracts. Guarantees that...
 	///	- on exit, if no exception is thrown, the returned node is a leaf.
@@ -274,6 +284,10 @@ private:
 		TreePath path;
 		std::size_t key_expected_pos;
 		bool key_is_present;
+		bool key_is_expired{false};
+
+		/// Whether the key is present and its entry has not expired
+		[[nodiscard]] bool key_is_live() const noexcept { return key_is_present && !key_is_expired; }
 	};
 
 	[[nodiscard]] SearchResultMark search_subtree(const Key &target_key, const Nod &origin, const Position origin_pos) {
@@ -321,7 +335,8 @@ private:
 		        .node = curr,
 		        .path = path,
 		        .key_expected_pos = key_expected_pos,
-		        .key_is_present = key_is_present};
+		        .key_is_present = key_is_present,
+		        .key_is_expired = key_is_present && curr.leaf().is_expired(key_expected_pos, Nod::now())};
 	}
 
 	[[nodiscard]] SearchResultMark search(const Key &target_key) {
@@ -362,6 +377,14 @@ private:
 		return get_corner_subtree_at_height(node, corner).first;
 	}
 
+	/// Position of the leftmost leaf in the tree
+	[[nodiscard]] Position __min_leaf_pos() {
+		auto root_node = root();
+		if (root_node.is_leaf())
+			return m_rootpos;
+		return get_corner_subtree_at_height(root_node, CornerDetail::MIN).second;
+	}
+
 	/// Make tree root
 	/// Create a new tree level
 	/// This can either happen if the tree has no root element at all, or because a node
@@ -373,7 +396,8 @@ private:
 		                    NewTreeLevel,
 		                    DuringBulkRebalancing };
 
-	Nod make_root(MakeRootAction action) {
+	/// For 'NewTreeLevel', 'current_root' could be passed in case the root page does not hold its latest state.
+	Nod make_root(MakeRootAction action, std::optional<Nod> current_root = {}) {
 		/// Although this function is mainly associated with changes in the logical contents of the tree, for which btl is no associated,
 		/// there are also modifications to the tree instance, more specifically - the root position.
 		std::unique_lock<std::shared_mutex> _guard{m_lock.get()};
@@ -382,7 +406,7 @@ private:
 			if (action == MakeRootAction::BareInit)
 				return Nod::template metadata_ctor<typename Nod::Leaf>();
 
-			auto old_root = __root();
+			auto old_root = current_root ? std::move(*current_root) : __root();
 			auto old_pos = m_rootpos;
 			old_root.set_parent(new_pos);
 			old_root.set_root_status(Nod::RootStatus::IsInternal);
@@ -405,8 +429,8 @@ private:
 		return new_root;
 	}
 
-	void rebalance_after_insert(TreePath &visited, const SplitBias bias) {
-		std::optional<Nod> node;
+	/// 'node' is the changed leaf, unless its page is already up-to-date.
+	void rebalance_after_insert(TreePath &visited, const SplitBias bias, std::optional<Nod> node = {}) {
 		while (true) {
 			const PosNod &path_of_node = visited.top();
 			if (!node)
@@ -417,12 +441,15 @@ private:
 				break;
 
 			if (node->is_root()) {
-				[[maybe_unused]] const auto new_root = make_root(MakeRootAction::NewTreeLevel);
+				[[maybe_unused]] const auto new_root = make_root(MakeRootAction::NewTreeLevel, std::move(node));
 				break;
 			}
 
 			auto [midkey, sibling] = node_split(*node, bias);
 			auto sibling_pos = m_pager->alloc();
+			// The sibling is placed right after the node in the leaf chain.
+			if (const auto next = node->next_node(); next)
+				sibling.set_next_node(*next);
 			node->set_next_node(sibling_pos);
 
 			visited.pop();
@@ -553,6 +580,10 @@ private:
 				node.leaf().keys.insert(node.leaf().keys.cbegin() + borrowed_dest_idx, sibling.leaf().keys.at(borrowed_idx));
 				sibling.leaf().vals.erase(sibling.leaf().vals.cbegin() + borrowed_idx);
 				sibling.leaf().keys.erase(sibling.leaf().keys.cbegin() + borrowed_idx);
+				if constexpr (Nod::TTL_ENTRIES) {
+					node.leaf().expiry.insert(node.leaf().expiry.cbegin() + borrowed_dest_idx, sibling.leaf().expiry.at(borrowed_idx));
+					sibling.leaf().expiry.erase(sibling.leaf().expiry.cbegin() + borrowed_idx);
+				}
 			} else {
 				// We are currently propagating a merge operation upwards in the tree.
 			}
@@ -648,8 +679,8 @@ private:
 
 		std::unique_lock<std::shared_mutex> _guard{m_lock.get()};
 		if constexpr (Config::DYN_ENTRIES) {
-			if (!m_ind_vector.has_value())
-				m_ind_vector.emplace(fmt::format("{}-indvector", m_identifier), IndirectionVector<Config>::ActionOnConstruction::DoNotLoad);
+			if (!m_ind_vector)
+				m_ind_vector = std::make_shared<IndirectionVector<Config>>(fmt::format("{}-indvector", m_identifier), IndirectionVector<Config>::ActionOnConstruction::DoNotLoad);
 		}
 
 		/// Space evaluation done here.
@@ -660,50 +691,122 @@ private:
 		m_num_links_branch = BRANCHING_FACTOR_BRANCH > 0
 		        ? BRANCHING_FACTOR_BRANCH
 		        : ::internal::binsearch_primitive(2ul, PAGE_SIZE / 2, [](auto current, auto, auto) {
-			          return nop::Encoding<Nod>::Size({typename Nod::Metadata(typename Nod::Branch(std::vector<Ref>(current), std::vector<Position>(current), std::vector<LinkStatus>(current))), 10, Nod::RootStatus::IsInternal}) - PAGE_SIZE;
+			          return nop::Encoding<Nod>::Size({typename Nod::Metadata(typename Nod::Branch(std::vector<Ref>(current), std::vector<Position>(current), std::vector<LinkStatus>(current))), 10, Nod::RootStatus::IsInternal}) - Nod::NODE_AREA_SIZE;
 		          }).value_or(0);
 		m_num_records_branch = m_num_links_branch - 1;
 
 		auto num_records_leaf_candidate = BRANCHING_FACTOR_LEAF > 0
 		        ? BRANCHING_FACTOR_LEAF
 		        : ::internal::binsearch_primitive(1ul, PAGE_SIZE / 2, [](auto current, auto, auto) {
-			          return nop::Encoding<Nod>::Size({typename Nod::Metadata(typename Nod::Leaf(std::vector<Key>(current), std::vector<Val>(current))), 10, Nod::RootStatus::IsInternal}) - PAGE_SIZE;
+			          /// Expiration times are accounted for with their largest encoding.
+			          std::vector<Expiry> expiry(Nod::TTL_ENTRIES ? current : 0, std::numeric_limits<Expiry>::max());
+			          const std::size_t expiry_size = Nod::TTL_ENTRIES ? nop::Encoding<std::vector<Expiry>>::Size(expiry) : 0;
+			          const Nod leaf{typename Nod::Metadata(typename Nod::Leaf(std::vector<Key>(current), std::vector<Val>(current), std::move(expiry))), 10, Nod::RootStatus::IsInternal};
+			          /// Packed keys are accounted for separately, their worst case is the raw encoding.
+			          return (Nod::PACKED_KEYS ? nop::Encoding<Nod>::Size(leaf) + expiry_size : leaf.encoded_size()) - Nod::NODE_AREA_SIZE;
 		          }).value_or(0);
 
 		m_num_records_leaf = num_records_leaf_candidate - 1 >= m_num_records_branch * 2
 		        ? m_num_records_branch * 2 - 1
 		        : num_records_leaf_candidate - 1;
+
+		__calc_num_records_packed_leaf();
+	}
+
+	/// Leaves with packed keys are limited by the size of their encoding. Still, the number of their entries is bounded
+	/// by the capacity of a leaf with consecutive keys, which is the best case for the encoding. Their minimum is the
+	/// same as for regular leaves, thus two underflown leaves could always be merged into a single page.
+	void __calc_num_records_packed_leaf() {
+		if constexpr (Nod::PACKED_KEYS) {
+			if (BRANCHING_FACTOR_LEAF > 0) {
+				m_num_records_packed_leaf = m_num_records_leaf;
+				return;
+			}
+			const auto candidate = ::internal::binsearch_primitive(1ul, PAGE_SIZE * CHAR_BIT, [](auto current, auto, auto) {
+				                       std::vector<Key> keys(current);
+				                       std::iota(keys.begin(), keys.end(), Key{});
+				                       return Nod{typename Nod::Metadata(typename Nod::Leaf(std::move(keys), std::vector<Val>(current), std::vector<Expiry>(Nod::TTL_ENTRIES ? current : 0, std::numeric_limits<Expiry>::max()))), 10, Nod::RootStatus::IsInternal}.encoded_size() - Nod::NODE_AREA_SIZE;
+			                       }).value_or(1);
+			m_num_records_packed_leaf = std::min(candidate - 1, m_num_records_branch * 2 - 1);
+		}
+	}
+
+	/// Place a leaf which was changed by a single entry
+	/// With delta chains enabled (see 'Config::LEAF_DELTA_CHAIN') only 'delta' is appended to the leaf page,
+	/// otherwise, or if the chain is already full, the whole node is encoded anew which folds the chain.
+	void place_leaf_delta(const Position pos, const Nod &node, const typename Nod::Delta &delta) {
+		if constexpr (Nod::DELTA_CHAINS) {
+			bool appended = false;
+			m_pager->modify(pos, [&](Page &page) { appended = Nod::append_delta(page, delta); });
+			if (appended)
+				return;
+		}
+		m_pager->place(pos, node.make_page());
 	}
 
 	/// Create new <key, value> entry into the tree.
 	/// Wraps insertion/replacement logic. If the key is already present into the tree, it takes action based
-	/// on the 'action' flag passed. The returned value denotes whether a new entry was put into the tree.
+	/// on the 'action' flag passed. The returned value denotes whether the change was applied - for 'AbandonChange'
+	/// that a new entry was put into the tree, for 'SubmitChange' that the value of the existing one was replaced.
 	/// 'BadTreeInsert' may be thrown if an error occurs.
 	/// It gets called by both 'insert()' and 'update()'.
-
-	[[nodiscard]] InsertionReturnMark place_kv_entry(const Key &key, const Val &val, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange, SplitBias split_bias = SplitBias::DistributeEvenly) {
-		return place_kv_entry(Entry{.key = key, .val = val}, action, split_bias);
+	///
+	/// The key and the value are forwarded all the way into the leaf, so rvalue arguments are never copied.
+	template<typename K, typename V>
+	requires std::convertible_to<K, Key> && std::convertible_to<V, RealVal>
+	[[nodiscard]] InsertionReturnMark place_kv_entry(K &&key, V &&val, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange, SplitBias split_bias = SplitBias::DistributeEvenly, Expiry expires_at = Nod::expiry_after(Config::ENTRY_TTL)) {
+		return place_kv_entry_with(
+		        std::forward<K>(key), [&] { return set_value(std::forward<V>(val)); }, action, split_bias, expires_at);
 	}
 
 	[[nodiscard]] InsertionReturnMark place_kv_entry(const Entry &entry, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange, SplitBias split_bias = SplitBias::DistributeEvenly) {
+		return place_kv_entry(entry.key, entry.val, action, split_bias);
+	}
+
+	[[nodiscard]] InsertionReturnMark place_kv_entry(Entry &&entry, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange, SplitBias split_bias = SplitBias::DistributeEvenly) {
+		return place_kv_entry(std::move(entry.key), std::move(entry.val), action, split_bias);
+	}
+
+	/// Same as 'place_kv_entry', but the stored value is produced by 'make_val' which returns an already
+	/// stored 'Val' (i.e a slot id when using DYN_ENTRIES). It is invoked only if the change is going to be applied,
+	/// thus abandoned changes neither construct nor store a value.
+	/// An expired entry is treated as absent, but it is replaced in place instead of inserting the key anew.
+	template<typename K, std::invocable MakeVal>
+	[[nodiscard]] InsertionReturnMark place_kv_entry_with(K &&key, MakeVal &&make_val, ActionOnKeyPresent action, SplitBias split_bias, Expiry expires_at = Nod::expiry_after(Config::ENTRY_TTL)) {
 		/// Locate position
-		auto search_res = search(entry.key);
+		auto search_res = search(key);
 
-		if ((action == ActionOnKeyPresent::AbandonChange && search_res.key_is_present)
-		    || (action == ActionOnKeyPresent::SubmitChange && !search_res.key_is_present))
+		if ((action == ActionOnKeyPresent::AbandonChange && search_res.key_is_live())
+		    || (action == ActionOnKeyPresent::SubmitChange && !search_res.key_is_live()))
 			return InsertedNothing();
 
 		auto &leaf_node = search_res.node.leaf();
+		const auto idx = search_res.key_expected_pos;
+
+		/// Replace the value of the existing element. The shape of the tree remains the same.
+		if (search_res.key_is_present) {
+			auto old_val = std::exchange(leaf_node.vals[idx], make_val());
+			if constexpr (Config::DYN_ENTRIES)
+				ind_vector().remove_slot(old_val);
+			if constexpr (Nod::TTL_ENTRIES)
+				leaf_node.expiry[idx] = expires_at;
+			place_leaf_delta(search_res.path.top().node_pos, search_res.node, {.kind = Nod::DeltaKind::Update, .key = leaf_node.keys[idx], .val = leaf_node.vals[idx], .expiry = expires_at});
+			return InsertedEntry();
+		}
+
 		/// Insert new element
-		leaf_node.keys.insert(leaf_node.keys.cbegin() + search_res.key_expected_pos, entry.key);
-		leaf_node.vals.insert(leaf_node.vals.cbegin() + search_res.key_expected_pos, set_value(entry.val));
-		m_pager->place(search_res.path.top().node_pos, search_res.node.make_page());
+		leaf_node.vals.insert(leaf_node.vals.cbegin() + idx, make_val());
+		leaf_node.keys.insert(leaf_node.keys.cbegin() + idx, std::forward<K>(key));
+		if constexpr (Nod::TTL_ENTRIES)
+			leaf_node.expiry.insert(leaf_node.expiry.cbegin() + idx, expires_at);
+		place_leaf_delta(search_res.path.top().node_pos, search_res.node, {.kind = Nod::DeltaKind::Insert, .key = leaf_node.keys[idx], .val = leaf_node.vals[idx], .expiry = expires_at});
 
 		/// Update stats
 		++m_size;
 
 		/// Rebalance
-		rebalance_after_insert(search_res.path, split_bias);
+		/// The leaf is passed as it is, since it might not have fit in its page if it is over.
+		rebalance_after_insert(search_res.path, split_bias, std::move(search_res.node));
 
 		return InsertedEntry();
 	}
@@ -711,60 +814,95 @@ private:
 	/// Places _many_ <key, value> entries inside the tree.
 	/// Leaves the tree in an unbalanced shape. More efficient version of calling `place_kv_entry` many times.
 	/// Returns return marks for each <key, value> Entry and a collection of all insertion trees that were created.
+	/// The marks are aligned with 'bulk' - the i-th mark corresponds to the i-th entry.
 	/// The latter is used during rebalancing.
 	/// The client code could take advantage of this, by buffering the insertion/update queries.
-	[[nodiscard]] auto place_kv_entries(std::ranges::range auto &&bulk, ActionOnKeyPresent action) {
+	/// If 'bulk' is passed as an rvalue its keys and values are moved into the tree rather than copied.
+	[[nodiscard]] auto place_kv_entries(std::ranges::forward_range auto &&bulk, ActionOnKeyPresent action) {
 		namespace rng = std::ranges;
 
-		ManyInsertionReturnMarks insertion_marks;
+		/// Views do not own their elements, so those are never moved from.
+		constexpr bool bulk_is_movable = !std::is_lvalue_reference_v<decltype(bulk)> && !rng::view<std::remove_cvref_t<decltype(bulk)>>;
+		auto take = [](auto &item) -> decltype(auto) {
+			if constexpr (bulk_is_movable)
+				return std::move(item);
+			else
+				return std::as_const(item);
+		};
+
+		ManyInsertionReturnMarks insertion_marks(rng::distance(bulk), InsertedNothing());
+		/// Entries of the bulk are placed one after another, so this is the index of the next one.
+		std::size_t bulk_idx = 0;
 		std::vector<InsertionTree<Key>> insertion_trees;
+		[[maybe_unused]] const auto now = Nod::now();
 
-		for (auto simple_bulk_cbegin = rng::cbegin(bulk); simple_bulk_cbegin != rng::cend(bulk);) {
-			auto search_result = search(simple_bulk_cbegin->key);
+		for (auto simple_bulk_begin = rng::begin(bulk); simple_bulk_begin != rng::end(bulk);) {
+			auto search_result = search(simple_bulk_begin->key);
 			PosNod path_to_leaf = consume_back<PosNod>(search_result.path);
 			std::optional<Position> parent_pos = search_result.path.empty() ? std::nullopt : std::make_optional(search_result.path.top().node_pos);
 
-			const auto leaf_vals_cbegin = search_result.node.leaf().vals.cbegin();
-			const auto leaf_keys_cbegin = search_result.node.leaf().keys.cbegin();
-			const auto leaf_keys_cend = search_result.node.leaf().keys.cend();
+			/// The leaf is a decoded copy which gets replaced by the insertion tree, so its entries are moved over.
+			auto &leaf = search_result.node.leaf();
 
-			const auto simple_bulk_cend = [&] {
-				if (leaf_keys_cbegin == leaf_keys_cend) {
+			const auto simple_bulk_end = [&] {
+				if (leaf.keys.empty()) {
 					/// In such case, the leaf is empty, and since that would mean that the tree is not properly balanced, this means that the subtree is empty as well.
 					/// Therefore, the highkey (or the upper fence key) equals +∞, meaning that all entries of the bulk should be located in this leaf.
-					return rng::cend(bulk);
+					return rng::end(bulk);
 				}
-				const Key &leaf_highkey = *(leaf_keys_cend - 1);
-				return std::find_if(simple_bulk_cbegin, rng::cend(bulk), [&leaf_highkey](const auto &entry) { return entry.key > leaf_highkey; });
+				/// The search routed the first entry to this leaf even if it is bigger than the leaf's highkey
+				/// (the separator in the parent may be bigger than it), so it always belongs here.
+				const Key &leaf_highkey = leaf.keys.back();
+				return std::find_if(std::next(simple_bulk_begin), rng::end(bulk), [&leaf_highkey](const auto &entry) { return entry.key > leaf_highkey; });
 			}();
 
-			auto entry_of_key_it = [leaf_keys_cbegin, leaf_vals_cbegin, this](auto it) {
-				return Entry{.key = *it, .val = get_value(*(leaf_vals_cbegin + std::distance(leaf_keys_cbegin, it)))};
-			};
-
-			auto iterate_over_simple_bulk = [simple_bulk_cit = simple_bulk_cbegin, leaf_keys_cit = leaf_keys_cbegin, simple_bulk_cend, leaf_keys_cend, &entry_of_key_it]() mutable -> cppcoro::generator<const Entry> {
-				while (simple_bulk_cit != simple_bulk_cend && leaf_keys_cit != leaf_keys_cend)
-					if (simple_bulk_cit->key < *leaf_keys_cit)
-						co_yield *simple_bulk_cit++;
-					else
-						co_yield entry_of_key_it(leaf_keys_cit++);
-				while (leaf_keys_cit != leaf_keys_cend)
-					co_yield entry_of_key_it(leaf_keys_cit++);
-				while (simple_bulk_cit != simple_bulk_cend)
-					co_yield *simple_bulk_cit++;
-			};
+			/// The last entry of the simple bulk, found without stepping back, which forward ranges cannot do
+			auto simple_bulk_last = simple_bulk_begin;
+			for (auto it = simple_bulk_begin; it != simple_bulk_end; ++it)
+				simple_bulk_last = it;
 
 			insertion_trees.push_back(InsertionTree{
 			        .path = search_result.path,
 			        .tree = clone_only_blueprint(),
-			        .lofence = simple_bulk_cbegin->key,
-			        .hifence = simple_bulk_cend > simple_bulk_cbegin ? (simple_bulk_cend - 1)->key : simple_bulk_cbegin->key,
+			        .lofence = simple_bulk_begin->key,
+			        .hifence = simple_bulk_last->key,
 			        .leaf_pos = path_to_leaf.node_pos});
 			auto &insertion_tree = insertion_trees.back();
 
-			rng::for_each(iterate_over_simple_bulk(), [&](const auto &entry) {
-				insertion_marks[entry.key] = insertion_tree.tree.place_kv_entry(typename Nod::Entry{.key = entry.key, .val = entry.val}, action, SplitBias::LeanLeft);
-			});
+			/// Entries already present in the leaf are placed with their stored values as they are - no value is
+			/// fetched or stored again. On equal keys they go first, so that 'action' decides about the bulk entry.
+			/// Expired entries are dropped while the leaf is being rewritten anyway.
+			auto place_from_leaf = [&](const std::size_t idx) {
+				if constexpr (Nod::TTL_ENTRIES) {
+					if (leaf.is_expired(idx, now)) {
+						if constexpr (Config::DYN_ENTRIES)
+							ind_vector().remove_slot(leaf.vals[idx]);
+						--m_size;
+						return;
+					}
+				}
+				[[maybe_unused]] const auto mark = insertion_tree.tree.place_kv_entry_with(
+				        std::move(leaf.keys[idx]), [&] { return std::move(leaf.vals[idx]); }, ActionOnKeyPresent::AbandonChange, SplitBias::LeanLeft,
+				        Nod::TTL_ENTRIES ? leaf.expiry[idx] : Expiry{0});
+			};
+			auto place_from_bulk = [&](auto it) {
+				auto &&entry = *it;
+				insertion_marks[bulk_idx++] = insertion_tree.tree.place_kv_entry_with(
+				        take(entry.key), [&] { return set_value(take(entry.val)); }, action, SplitBias::LeanLeft);
+			};
+
+			auto simple_bulk_it = simple_bulk_begin;
+			std::size_t leaf_idx = 0;
+			while (simple_bulk_it != simple_bulk_end && leaf_idx < leaf.keys.size())
+				if (simple_bulk_it->key < leaf.keys[leaf_idx])
+					place_from_bulk(simple_bulk_it++);
+				else
+					place_from_leaf(leaf_idx++);
+			while (leaf_idx < leaf.keys.size())
+				place_from_leaf(leaf_idx++);
+			while (simple_bulk_it != simple_bulk_end)
+				place_from_bulk(simple_bulk_it++);
+
 			/// Replace leaf with insertion tree root
 			auto pos = [&] {
 				// No parent, nor siblings => root element
@@ -792,7 +930,7 @@ private:
 			m_pager->place(pos, insertion_tree.tree.root().make_page());
 
 			// Update current position in simple bulk
-			simple_bulk_cbegin = simple_bulk_cend;
+			simple_bulk_begin = simple_bulk_end;
 
 			// Return the last record of the path since it was popped earlier.
 			// However, update its nodepos to the current 'rootpos()' of the insertion tree.
@@ -805,7 +943,7 @@ private:
 
 private:
 	long __min_num_records_leaf() const noexcept { return (m_num_records_leaf + 1) / 2; }
-	long __max_num_records_leaf() const noexcept { return m_num_records_leaf; }
+	long __max_num_records_leaf() const noexcept { return Nod::PACKED_KEYS ? m_num_records_packed_leaf : m_num_records_leaf; }
 	long __min_num_records_branch() const noexcept { return (m_num_records_branch + 1) / 2; }
 	long __max_num_records_branch() const noexcept { return m_num_records_branch; }
 
@@ -884,7 +1022,7 @@ public:
 	}
 	[[nodiscard]] long max_num_records_leaf() const noexcept {
 		std::shared_lock<std::shared_mutex> _guard{m_lock.get()};
-		return m_num_records_leaf;
+		return __max_num_records_leaf();
 	}
 
 	/// Get limits of the size of branch nodes (branch contain [min; max] entries)
@@ -908,7 +1046,7 @@ private:
 		using namespace ::internal::storage;
 		if constexpr (!Config::DYN_ENTRIES)
 			throw BadIndVector(" - Not using DYN_ENTRIES option");
-		assert(m_ind_vector.has_value());
+		assert(m_ind_vector);
 		return *m_ind_vector;
 	}
 
@@ -923,7 +1061,7 @@ public:
 	/// Dynamic entries
 	///
 
-	[[nodiscard]] RealVal get_value(Val val_or_slot) {
+	[[nodiscard]] RealVal get_value(const Val &val_or_slot) {
 		if constexpr (Config::DYN_ENTRIES) {
 			return ind_vector().get_from_slot(val_or_slot);
 		} else {
@@ -932,12 +1070,14 @@ public:
 		}
 	}
 
-	[[nodiscard]] Val set_value(RealVal val) {
+	template<typename V>
+	requires std::constructible_from<RealVal, V>
+	[[nodiscard]] Val set_value(V &&val) {
 		if constexpr (Config::DYN_ENTRIES) {
-			return ind_vector().set_to_slot(val);
+			return ind_vector().set_to_slot(RealVal(std::forward<V>(val)));
 		} else {
 			static_assert(std::same_as<Val, RealVal>);
-			return val;
+			return Val(std::forward<V>(val));
 		}
 	}
 
@@ -952,38 +1092,65 @@ public:
 	/// whether the key is distinct.
 	/// An exception 'BadTreeInsert' may be thrown if an unexpected error occurs. It contains an
 	/// appropriate message describing the failure.
-	constexpr InsertionReturnMark insert(const Key &key, const RealVal &val) {
-		return place_kv_entry(Entry{.key = key, .val = val}, ActionOnKeyPresent::AbandonChange);
+	/// Rvalue arguments are moved into the tree.
+	template<typename K, typename V>
+	requires std::constructible_from<Key, K> && std::constructible_from<RealVal, V>
+	constexpr InsertionReturnMark insert(K &&key, V &&val) {
+		return place_kv_entry(std::forward<K>(key), std::forward<V>(val), ActionOnKeyPresent::AbandonChange);
 	}
 
 	constexpr InsertionReturnMark insert(const Entry &entry) {
 		return place_kv_entry(entry, ActionOnKeyPresent::AbandonChange);
 	}
 
+	constexpr InsertionReturnMark insert(Entry &&entry) {
+		return place_kv_entry(std::move(entry), ActionOnKeyPresent::AbandonChange);
+	}
+
+	/// Same as 'insert', but the entry expires once 'lifetime' passes, instead of after 'Config::ENTRY_TTL'.
+	/// A non-positive 'lifetime' makes the entry persistent.
+	template<typename K, typename V>
+	requires Nod::TTL_ENTRIES && std::constructible_from<Key, K> && std::constructible_from<RealVal, V>
+	InsertionReturnMark insert(K &&key, V &&val, const std::chrono::milliseconds lifetime) {
+		return place_kv_entry(std::forward<K>(key), std::forward<V>(val), ActionOnKeyPresent::AbandonChange, SplitBias::DistributeEvenly, Nod::expiry_after(lifetime));
+	}
+
+	/// Same as 'insert', but the value is constructed in place from 'args'.
+	/// The value is only constructed if 'key' is not already present in the tree.
+	template<typename K, typename... Args>
+	requires std::constructible_from<Key, K> && std::constructible_from<RealVal, Args...>
+	constexpr InsertionReturnMark emplace(K &&key, Args &&...args) {
+		return place_kv_entry_with(
+		        std::forward<K>(key), [&] { return set_value(RealVal(std::forward<Args>(args)...)); }, ActionOnKeyPresent::AbandonChange, SplitBias::DistributeEvenly);
+	}
+
 	/// Submit a set of <key, value> entries into the tree, i.e bulk insertion.
 	/// Requires that the entries in 'bulk' are sorted in ascending order.
 	/// Implementation is according to "Concurrency Control and I/O-Optimality in Bulk Insertion".
-	std::unordered_map<Key, InsertionReturnMark> insert_many(std::ranges::range auto &&bulk, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange) {
+	/// The returned marks are aligned with 'bulk'. If 'bulk' is an rvalue, its entries are moved into the tree.
+	ManyInsertionReturnMarks insert_many(std::ranges::range auto &&bulk, ActionOnKeyPresent action = ActionOnKeyPresent::AbandonChange) {
 		namespace rng = std::ranges;
 
 		if (rng::empty(bulk))
 			return {};
 
+		auto &&[insertion_marks, insertion_trees] = place_kv_entries(std::forward<decltype(bulk)>(bulk), action);
+		/// Taken after the placement, since it drops the expired entries of the rewritten leaves.
 		auto tmp = m_size;
-		auto &&[insertion_marks, insertion_trees] = place_kv_entries(bulk, action);
 		rebalance_after_bulk_insert(insertion_trees);
-		m_size = tmp + rng::count_if(bulk, [&](const auto &entry) {
-			         return insertion_marks.contains(entry.key) && std::holds_alternative<InsertedEntry>(insertion_marks.at(entry.key));
-		         });
+		/// Updated entries do not change the size of the tree.
+		m_size = tmp;
+		if (action == ActionOnKeyPresent::AbandonChange)
+			m_size += rng::count_if(insertion_marks, [](const auto &mark) { return std::holds_alternative<InsertedEntry>(mark); });
 
-		return insertion_marks;
+		return std::move(insertion_marks);
 	}
 
 	/// Remove an existing <key, value> entry from the tree
 	/// If no such entry with the given key is found, no change is made to tree. The returned value
 	/// may contain either 'RemovedVal(Val)' containing a copy of the removed value, or 'RemovedNothing()'
 	/// if no such key was found. It is possible for 'BadTreeRemove' to be thrown if an unexpected
-	/// error occurs.
+	/// error occurs. An expired entry is discarded as well, but 'RemovedNothing()' is returned for it.
 	///
 	/// Slight caveat: only the value is discarded from the tree. The key remains since it does not
 	/// break in any way any of the tree invariants. It remains as an additional element to compare with
@@ -1007,12 +1174,14 @@ public:
 
 		/// Erase element
 		node_leaf.keys.erase(node_leaf.keys.cbegin() + search_res.key_expected_pos);
+		if constexpr (Nod::TTL_ENTRIES)
+			node_leaf.expiry.erase(node_leaf.expiry.cbegin() + search_res.key_expected_pos);
 		if constexpr (Config::DYN_ENTRIES) {
 			auto slot_id_it = node_leaf.vals.cbegin() + search_res.key_expected_pos;
 			ind_vector().remove_slot(*slot_id_it);
 		}
 		node_leaf.vals.erase(node_leaf.vals.cbegin() + search_res.key_expected_pos);
-		m_pager->place(node_path.node_pos, search_res.node.make_page());
+		place_leaf_delta(node_path.node_pos, search_res.node, {.kind = Nod::DeltaKind::Remove, .key = key, .val = {}});
 
 		/// Update stats
 		fmt::print("removing '{}', size is now '{}'\n", key, m_size);
@@ -1022,6 +1191,8 @@ public:
 		if constexpr (Config::BTREE_RELAXED_REMOVES)
 			rebalance_after_remove_relaxed(search_res.path);
 
+		if (search_res.key_is_expired)
+			return RemovedNothing();
 		return RemovedVal{.val = removed};
 	}
 
@@ -1040,8 +1211,257 @@ public:
 	/// If no such entry with the given key is found, 'InsertedNothing' is returned, else-
 	/// 'InsertedEntry'. An exception 'BadTreeInsert' may be thrown if an unexpected error
 	/// occurs. It contains an appropriate message describing the failure.
-	constexpr InsertionReturnMark update(const Key &key, const Val &val) {
-		return place_kv_entry(key, val, ActionOnKeyPresent::SubmitChange);
+	template<typename K, typename V>
+	requires std::constructible_from<Key, K> && std::constructible_from<RealVal, V>
+	constexpr InsertionReturnMark update(K &&key, V &&val) {
+		return place_kv_entry(std::forward<K>(key), std::forward<V>(val), ActionOnKeyPresent::SubmitChange);
+	}
+
+	/// Same as 'update', but the entry expires once 'lifetime' passes, instead of after 'Config::ENTRY_TTL'.
+	template<typename K, typename V>
+	requires Nod::TTL_ENTRIES && std::constructible_from<Key, K> && std::constructible_from<RealVal, V>
+	InsertionReturnMark update(K &&key, V &&val, const std::chrono::milliseconds lifetime) {
+		return place_kv_entry(std::forward<K>(key), std::forward<V>(val), ActionOnKeyPresent::SubmitChange, SplitBias::DistributeEvenly, Nod::expiry_after(lifetime));
+	}
+
+	/// Discard all expired entries from the tree
+	/// Expired entries are already invisible to the queries, but they keep occupying space until they
+	/// are either overwritten or purged. The tree is walked once from the root and each leaf which contains
+	/// expired entries gets rewritten once with all of them dropped - there is no search from the root per
+	/// entry. The children of each branch are rebalanced right after their subtrees are purged: the empty ones
+	/// are freed, and the underflown ones are merged with a sibling, or take entries over from it. A root which
+	/// is left with a single child is replaced by it. Returns the number of purged entries.
+	std::size_t purge_expired() requires Nod::TTL_ENTRIES {
+		PurgeWalk walk{.now = Nod::now()};
+		auto root_node = root();
+		if (root_node.is_leaf()) {
+			if (drop_expired(root_node, walk) > 0)
+				m_pager->place(m_rootpos, root_node.make_page());
+			return walk.num_purged;
+		}
+
+		const bool root_changed = purge_expired_below(root_node, walk);
+		if (walk.last_kept) {
+			auto &[last_pos, last] = *walk.last_kept;
+			if (last.next_node()) {
+				last.clear_next_node();
+				walk.last_kept_changed = true;
+			}
+			if (walk.last_kept_changed)
+				m_pager->place(last_pos, last.make_page());
+		}
+
+		if (root_node.branch().links.empty()) {
+			/// All entries have expired.
+			root_node = Nod{Nod::template metadata_ctor<typename Nod::Leaf>(), 0, Nod::RootStatus::IsRoot};
+			m_pager->place(m_rootpos, root_node.make_page());
+			m_depth = 1;
+			return walk.num_purged;
+		}
+
+		if (root_changed)
+			m_pager->place(m_rootpos, root_node.make_page());
+		while (root_node.is_branch() && root_node.branch().links.size() == 1) {
+			const auto child_pos = root_node.branch().links.front();
+			root_node = Nod::from_page(m_pager->get(child_pos));
+			root_node.set_root_status(Nod::RootStatus::IsRoot);
+			m_pager->place(child_pos, root_node.make_page());
+			m_pager->free(m_rootpos);
+			m_rootpos = child_pos;
+			--m_depth;
+		}
+		return walk.num_purged;
+	}
+
+private:
+	/// State of 'purge_expired()'
+	/// The last kept leaf is placed only once the next one is known, so that the leaf chain could skip the freed leaves.
+	struct PurgeWalk {
+		Expiry now;
+		std::size_t num_purged{0};
+		std::optional<std::pair<Position, Nod>> last_kept{};
+		bool last_kept_changed{false};
+	};
+
+	struct PurgedChild {
+		Position pos;
+		Nod node;
+		bool changed;
+	};
+
+	/// Drop the expired entries of a leaf. Returns their number.
+	std::size_t drop_expired(Nod &node, PurgeWalk &walk) requires Nod::TTL_ENTRIES {
+		auto &leaf = node.leaf();
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < leaf.keys.size(); ++i) {
+			if (leaf.is_expired(i, walk.now)) {
+				if constexpr (Config::DYN_ENTRIES)
+					ind_vector().remove_slot(leaf.vals[i]);
+				continue;
+			}
+			if (kept != i) {
+				leaf.keys[kept] = std::move(leaf.keys[i]);
+				leaf.vals[kept] = std::move(leaf.vals[i]);
+				leaf.expiry[kept] = leaf.expiry[i];
+			}
+			++kept;
+		}
+
+		const std::size_t num_expired = leaf.keys.size() - kept;
+		leaf.keys.resize(kept);
+		leaf.vals.resize(kept);
+		leaf.expiry.resize(kept);
+		m_size -= num_expired;
+		walk.num_purged += num_expired;
+		return num_expired;
+	}
+
+	/// Purge the subtree of the branch 'node' and rebalance its children, which are placed along the way
+	/// Returns whether 'node' itself changed, in which case the caller places it.
+	bool purge_expired_below(Nod &node, PurgeWalk &walk) requires Nod::TTL_ENTRIES {
+		auto &br = node.branch();
+		std::vector<PurgedChild> children;
+		children.reserve(br.links.size());
+		for (std::size_t i = 0; i < br.links.size(); ++i) {
+			if (br.link_status[i] != LinkStatus::Valid)
+				throw BadTreeRemove(fmt::format(" - invalid link w/ index={} in branch node during purge\n", i));
+			auto child = Nod::from_page(m_pager->get(br.links[i]));
+			const bool changed = child.is_branch() ? purge_expired_below(child, walk) : drop_expired(child, walk) > 0;
+			children.push_back(PurgedChild{.pos = br.links[i], .node = std::move(child), .changed = changed});
+		}
+
+		const bool changed = rebalance_purged_children(br.refs, children);
+		if (changed) {
+			br.links.clear();
+			for (const auto &child : children)
+				br.links.push_back(child.pos);
+			br.link_status.assign(children.size(), LinkStatus::Valid);
+		}
+
+		for (auto &child : children) {
+			if (child.node.is_branch()) {
+				if (child.changed)
+					m_pager->place(child.pos, child.node.make_page());
+				continue;
+			}
+
+			if (walk.last_kept) {
+				auto &[last_pos, last] = *walk.last_kept;
+				if (last.next_node() != child.pos) {
+					last.set_next_node(child.pos);
+					walk.last_kept_changed = true;
+				}
+				if (walk.last_kept_changed)
+					m_pager->place(last_pos, last.make_page());
+			}
+			walk.last_kept.emplace(child.pos, std::move(child.node));
+			walk.last_kept_changed = child.changed;
+		}
+		return changed;
+	}
+
+	/// Free the empty children of a branch and fix the underflown ones, 'refs' being the keys which separate them
+	/// An underflown child is merged with its right sibling (the left one for the last child). If both do not fit in
+	/// a single node, their entries are distributed evenly among them instead. Returns whether any child was freed or
+	/// got entries of another one.
+	bool rebalance_purged_children(std::vector<Ref> &refs, std::vector<PurgedChild> &children) requires Nod::TTL_ENTRIES {
+		bool changed = false;
+		for (std::size_t i = 0; i < children.size();) {
+			const auto &child = children[i].node;
+			if (child.is_leaf() ? !child.is_empty() : !child.branch().links.empty()) {
+				++i;
+				continue;
+			}
+			/// The range of the freed child is taken over by its left sibling, or by the right one if it is the first.
+			if (!refs.empty())
+				refs.erase(refs.cbegin() + (i > 0 ? i - 1 : 0));
+			m_pager->free(children[i].pos);
+			children.erase(children.cbegin() + i);
+			changed = true;
+		}
+
+		for (std::size_t i = 0; i < children.size() && children.size() > 1;) {
+			if (!is_node_under(children[i].node)) {
+				++i;
+				continue;
+			}
+
+			const std::size_t l = i + 1 < children.size() ? i : i - 1;
+			auto &left = children[l].node;
+			auto &right = children[l + 1].node;
+			if (left.is_leaf()) {
+				auto &lhs = left.leaf();
+				auto &rhs = right.leaf();
+				std::ranges::move(rhs.keys, std::back_inserter(lhs.keys));
+				std::ranges::move(rhs.vals, std::back_inserter(lhs.vals));
+				lhs.expiry.insert(lhs.expiry.cend(), rhs.expiry.cbegin(), rhs.expiry.cend());
+			} else {
+				auto &lhs = left.branch();
+				auto &rhs = right.branch();
+				lhs.refs.push_back(std::move(refs[l]));
+				std::ranges::move(rhs.refs, std::back_inserter(lhs.refs));
+				lhs.links.insert(lhs.links.cend(), rhs.links.cbegin(), rhs.links.cend());
+				lhs.link_status.insert(lhs.link_status.cend(), rhs.link_status.cbegin(), rhs.link_status.cend());
+			}
+			children[l].changed = true;
+			changed = true;
+
+			if (is_node_over(left)) {
+				auto [midkey, sibling] = node_split(left, SplitBias::DistributeEvenly);
+				right = std::move(sibling);
+				refs[l] = std::move(midkey);
+				children[l + 1].changed = true;
+				i = l + 2;
+			} else {
+				m_pager->free(children[l + 1].pos);
+				children.erase(children.cbegin() + l + 1);
+				refs.erase(refs.cbegin() + l);
+				i = l;
+			}
+		}
+		return changed;
+	}
+
+	/// The entry with the biggest key in the subtree of 'node' which has not expired
+	/// The subtrees are visited from the biggest keys backwards, until such an entry is found.
+	std::optional<Entry> last_live_entry(const Nod &node, const Expiry now) requires Nod::TTL_ENTRIES {
+		if (node.is_leaf()) {
+			const auto &leaf = node.leaf();
+			for (auto i = leaf.keys.size(); i-- > 0;)
+				if (!leaf.is_expired(i, now))
+					return std::make_optional<Entry>({.key = leaf.keys[i], .val = get_value(leaf.vals[i])});
+			return {};
+		}
+
+		const auto &br = node.branch();
+		for (auto i = br.links.size(); i-- > 0;) {
+			if (br.link_status[i] != LinkStatus::Valid)
+				continue;
+			if (auto entry = last_live_entry(Nod::from_page(m_pager->get(br.links[i])), now))
+				return entry;
+		}
+		return {};
+	}
+
+public:
+	/// Reclaim the space of removed and overwritten dynamic values
+	/// Only relevant when the values are kept in a value log - its segments which are mostly garbage get their
+	/// live values moved to the head of the log. Returns the number of collected segments.
+	std::size_t collect_garbage() requires(Config::DYN_ENTRIES && Config::VALUE_LOG) {
+		return ind_vector().collect_garbage();
+	}
+
+	/// Compact the pages in which the dynamic values are stored, spending about 'io_budget' bytes of I/O per call
+	/// Meant to be called repeatedly, e.g from a background task, until it returns true - see 'IndirectionVector::compact'.
+	bool compact_values(const std::size_t io_budget) requires(Config::DYN_ENTRIES && !Config::VALUE_LOG) {
+		return ind_vector().compact(io_budget);
+	}
+
+	/// Train the codec of the dynamic values on a sample of the stored ones
+	/// The values stored so far are re-encoded with the trained codec. Best done once the tree holds values which
+	/// are representative of the ones to come.
+	void train_value_codec(const std::size_t max_samples = 1000) requires(Config::DYN_ENTRIES && !std::same_as<typename Config::ValueCodec, storage::NoValueCodec>) {
+		ind_vector().train_codec(max_samples);
 	}
 
 	///
@@ -1054,7 +1474,7 @@ public:
 	/// rch' is thrown.
 	constexpr std::optional<RealVal> get(const Key &key) {
 		const auto search_result = search(key);
-		if (!search_result.key_is_present)
+		if (!search_result.key_is_live())
 			return {};
 
 		const auto &val = search_result.node.leaf().vals[search_result.key_expected_pos];
@@ -1064,7 +1484,7 @@ public:
 	/// Check whether <key, val> entry described by the given key is present in the tree
 	/// If an error occurs during the tree traversal 'BadTreeSearch' is thrown.
 	constexpr bool contains(const Key &key) {
-		return search(key).key_is_present;
+		return search(key).key_is_live();
 	}
 
 	/// Get the entry with the smallest key
@@ -1072,6 +1492,14 @@ public:
 		const auto node_with_smallest_keys = get_corner_subtree(root(), CornerDetail::MIN);
 		if (node_with_smallest_keys.num_filled() <= 0)
 			return {};
+		if constexpr (Nod::TTL_ENTRIES) {
+			/// The smallest entry has expired, so look for the first one which has not.
+			if (node_with_smallest_keys.leaf().is_expired(0, Nod::now())) {
+				for (const auto &entry : get_all_entries())
+					return entry;
+				return {};
+			}
+		}
 
 		return std::make_optional<Entry>({.key = node_with_smallest_keys.leaf().keys.front(),
 		                                  .val = get_value(node_with_smallest_keys.leaf().vals.front())});
@@ -1082,6 +1510,11 @@ public:
 		const auto node_with_biggest_keys = get_corner_subtree(root(), CornerDetail::MAX);
 		if (node_with_biggest_keys.num_filled() <= 0)
 			return {};
+		if constexpr (Nod::TTL_ENTRIES) {
+			/// The biggest entry has expired, so look for the last one which has not, starting from the biggest keys.
+			if (node_with_biggest_keys.leaf().is_expired(node_with_biggest_keys.num_filled() - 1, Nod::now()))
+				return last_live_entry(root(), Nod::now());
+		}
 
 		return std::make_optional<Entry>({.key = node_with_biggest_keys.leaf().keys.back(),
 		                                  .val = get_value(node_with_biggest_keys.leaf().vals.back())});
@@ -1089,15 +1522,26 @@ public:
 
 	/// Acquire all entries present in the tree
 	/// This returns a generator over <key, val> pairs using the `next_node` member in the nodes.
-	/// It does not traverse the whole tree, but only level 0.
+	/// It does not traverse the whole tree, but only level 0. Expired entries are skipped.
 	cppcoro::generator<const Entry &> get_all_entries() {
 		Nod curr = get_corner_subtree(root(), CornerDetail::MIN);
 		if (!curr.is_leaf())
 			throw BadTreeSearch(" - returned branch corner node\n");
 
+		[[maybe_unused]] const auto now = Nod::now();
 		while (true) {
-			for (const auto &&[key, val] : iter::zip(curr.leaf().keys, curr.leaf().vals))
-				co_yield Entry{.key = key, .val = get_value(val)};
+			const auto &leaf = curr.leaf();
+			/// Dyn values of the whole leaf are fetched in a single batch.
+			[[maybe_unused]] std::vector<RealVal> leaf_vals;
+			if constexpr (Config::DYN_ENTRIES)
+				leaf_vals = ind_vector().get_from_slots(leaf.vals);
+			for (std::size_t i = 0; i < leaf.keys.size(); ++i) {
+				if (leaf.is_expired(i, now))
+					continue;
+				/// Named, since some compilers destroy temporaries in 'co_yield' twice when the generator is dropped early.
+				const Entry entry{.key = leaf.keys[i], .val = Config::DYN_ENTRIES ? std::move(leaf_vals[i]) : get_value(leaf.vals[i])};
+				co_yield entry;
+			}
 			if (!curr.next_node())
 				co_return;
 			curr = Nod::from_page(m_pager->get(*curr.next_node()));
@@ -1131,6 +1575,49 @@ public:
 			co_yield entry;
 	}
 
+	/// Acquire a single field of the values of all entries, as <key, field> pairs
+	/// Requires columnar leaves (see 'Config::COLUMNAR_LEAVES'). Only the keys and the column of 'Field' are
+	/// decoded from each leaf, e.g 'get_all_in_column<&person::age>()' does not touch any names or emails.
+	template<auto Field>
+	requires Nod::COLUMNAR_LEAVES
+	cppcoro::generator<std::pair<const Key &, const typename Nod::template ColumnType<Field> &>> get_all_in_column() {
+		[[maybe_unused]] const auto now = Nod::now();
+		for (auto pos = std::make_optional(__min_leaf_pos()); pos;) {
+			auto slice = Nod::template read_column<Field>(m_pager->get(*pos));
+			if (!slice)
+				throw BadTreeSearch(" - leaf chain contains a branch node\n");
+			for (std::size_t i = 0; i < slice->keys.size(); ++i)
+				if (!slice->is_expired(i, now))
+					co_yield {slice->keys[i], slice->column[i]};
+			pos = slice->next_node;
+		}
+	}
+
+	/// Similar to 'get_all_in_column', but yields only the entries whose field satisfies 'predicate'.
+	/// The predicate is evaluated over the whole column of a leaf at once, in a tight loop without any
+	/// dependencies between the iterations, so that simple predicates over arithmetic fields could be vectorized.
+	template<auto Field>
+	requires Nod::COLUMNAR_LEAVES
+	cppcoro::generator<std::pair<const Key &, const typename Nod::template ColumnType<Field> &>> get_all_in_column_filtered(auto predicate) {
+		std::vector<uint8_t> matches;
+		[[maybe_unused]] const auto now = Nod::now();
+		for (auto pos = std::make_optional(__min_leaf_pos()); pos;) {
+			auto slice = Nod::template read_column<Field>(m_pager->get(*pos));
+			if (!slice)
+				throw BadTreeSearch(" - leaf chain contains a branch node\n");
+
+			const auto &column = slice->column;
+			matches.resize(column.size());
+			for (std::size_t i = 0; i < column.size(); ++i)
+				matches[i] = predicate(column[i]);
+
+			for (std::size_t i = 0; i < column.size(); ++i)
+				if (matches[i] && !slice->is_expired(i, now))
+					co_yield {slice->keys[i], column[i]};
+			pos = slice->next_node;
+		}
+	}
+
 	///
 	/// Persistence API
 	///
@@ -1154,13 +1641,14 @@ public:
 			m_num_records_leaf = header_.tree_num_leaf_records;
 			m_num_records_branch = header_.tree_num_branch_records;
 			m_num_links_branch = m_num_records_branch + 1;
+			__calc_num_records_packed_leaf();
 
 			m_pager->load();
 		}
 
 		if constexpr (Config::DYN_ENTRIES) {
-			if (!m_ind_vector.has_value())
-				m_ind_vector.emplace(fmt::format("{}-indvector", m_identifier), IndirectionVector<Config>::ActionOnConstruction::Load);
+			if (!m_ind_vector)
+				m_ind_vector = std::make_shared<IndirectionVector<Config>>(fmt::format("{}-indvector", m_identifier), IndirectionVector<Config>::ActionOnConstruction::Load);
 			else
 				__ind_vector().load();
 		}
@@ -1253,12 +1741,16 @@ private:
 	/// Minimum num of records stored in a leaf node
 	std::size_t m_num_records_leaf{0};
 
+	/// Maximum num of records stored in a leaf node with packed keys
+	std::size_t m_num_records_packed_leaf{0};
+
 	/// Minimum num of records stored in a branch node
 	std::size_t m_num_records_branch{0};
 	std::size_t m_num_links_branch{0};
 
 	// Contains value only if the option DYN ENTRIES is used
-	std::optional<IndirectionVector<Config>> m_ind_vector;
+	/// Shared with the insertion trees created during bulk insertion, the same way as the pager is.
+	std::shared_ptr<IndirectionVector<Config>> m_ind_vector;
 
 	// Big tree lock - protects only the properties of the tree on not its logical contents.
 	mutable TreeLock m_lock;
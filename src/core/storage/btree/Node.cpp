@@ -1,5 +1,7 @@
 #include <algorithm>
 #include <fstream>
+#include <limits>
+#include <numeric>
 #include <optional>
 #include <random>
 #include <ranges>
@@ -79,6 +81,149 @@ TEST_CASE("Node serialization", "[btree]") {
 	REQUIRE(node2_from_page == node2);
 }
 
+struct DeltaChainConfig : Config {
+	static inline constexpr int LEAF_DELTA_CHAIN = 4;
+	static inline constexpr std::size_t LEAF_DELTA_AREA = 128;
+};
+
+TEST_CASE("Node delta chains", "[btree]") {
+	using DNod = Node<DeltaChainConfig>;
+	using DeltaKind = DNod::DeltaKind;
+
+	auto node = DNod(DNod::Metadata(DNod::Leaf({2, 4, 6}, {20, 40, 60})), 13, DNod::RootStatus::IsInternal);
+	auto page = node.make_page();
+	REQUIRE(DNod::from_page(page) == node);
+
+	REQUIRE(DNod::append_delta(page, {.kind = DeltaKind::Insert, .key = 5, .val = 50}));
+	REQUIRE(DNod::append_delta(page, {.kind = DeltaKind::Update, .key = 2, .val = 21}));
+	REQUIRE(DNod::append_delta(page, {.kind = DeltaKind::Remove, .key = 6, .val = {}}));
+
+	auto expected = DNod(DNod::Metadata(DNod::Leaf({2, 4, 5}, {21, 40, 50})), 13, DNod::RootStatus::IsInternal);
+	auto replayed = DNod::from_page(page);
+	REQUIRE(replayed == expected);
+
+	/// The chain is full after LEAF_DELTA_CHAIN records and making a page folds it.
+	REQUIRE(DNod::append_delta(page, {.kind = DeltaKind::Insert, .key = 1, .val = 10}));
+	REQUIRE_FALSE(DNod::append_delta(page, {.kind = DeltaKind::Insert, .key = 3, .val = 30}));
+	auto folded = DNod::from_page(page).make_page();
+	REQUIRE(DNod::append_delta(folded, {.kind = DeltaKind::Insert, .key = 3, .val = 30}));
+	REQUIRE(DNod::from_page(folded).leaf().keys == std::vector<int>{1, 2, 3, 4, 5});
+}
+
+struct TtlConfig : DeltaChainConfig {
+	static inline constexpr bool TTL_ENTRIES = true;
+};
+
+TEST_CASE("Expiring entries in pages", "[btree]") {
+	using TNod = Node<TtlConfig>;
+	using DeltaKind = TNod::DeltaKind;
+
+	/// Only the pages of trees with expiring entries contain expiration times.
+	auto plain = Nod(Metadata(Leaf({2, 4, 6}, {20, 40, 60})), 13, Nod::RootStatus::IsInternal);
+	auto node = TNod(TNod::Metadata(TNod::Leaf({2, 4, 6}, {20, 40, 60}, {0, 100, 200})), 13, TNod::RootStatus::IsInternal);
+	REQUIRE(plain.encoded_size() == nop::Encoding<Nod>::Size(plain));
+	REQUIRE(node.encoded_size() > plain.encoded_size());
+
+	auto page = node.make_page();
+	REQUIRE(TNod::from_page(page) == node);
+
+	REQUIRE(TNod::append_delta(page, {.kind = DeltaKind::Insert, .key = 5, .val = 50, .expiry = 300}));
+	REQUIRE(TNod::append_delta(page, {.kind = DeltaKind::Update, .key = 2, .val = 21, .expiry = 400}));
+	auto expected = TNod(TNod::Metadata(TNod::Leaf({2, 4, 5, 6}, {21, 40, 50, 60}, {400, 100, 300, 200})), 13, TNod::RootStatus::IsInternal);
+	REQUIRE(TNod::from_page(page) == expected);
+}
+
+struct PackedKeysConfig : Config {
+	using Key = long;
+	using Ref = long;
+	static inline constexpr bool PACK_LEAF_KEYS = true;
+};
+
+TEST_CASE("Packed leaf keys", "[btree]") {
+	SECTION("Packing and unpacking") {
+		for (const std::size_t n : {0ul, 1ul, 7ul, 64ul, 1000ul}) {
+			auto keys = n_random_items<long>(n);
+			std::sort(keys.begin(), keys.end());
+			REQUIRE(PackedKeys<long>::pack(keys).unpack() == keys);
+		}
+
+		const std::vector<long> extremes{std::numeric_limits<long>::min(), -1, 0, std::numeric_limits<long>::max()};
+		REQUIRE(PackedKeys<long>::pack(extremes).unpack() == extremes);
+
+		std::vector<int> dense(500);
+		std::iota(dense.begin(), dense.end(), 1'000'000);
+		const auto packed = PackedKeys<int>::pack(dense);
+		REQUIRE(packed.width == 9);
+		REQUIRE(packed.words.size() == 500 * 9 / 64 + 2);
+		REQUIRE(packed.unpack() == dense);
+
+		/// A single key, or keys which are all equal, take no bits at all
+		for (const std::size_t n : {1ul, 2ul, 100ul}) {
+			const std::vector<long> equal(n, -42);
+			const auto packed_equal = PackedKeys<long>::pack(equal);
+			REQUIRE(packed_equal.width == 0);
+			REQUIRE(packed_equal.words.size() == 2);
+			REQUIRE(packed_equal.unpack() == equal);
+		}
+	}
+
+	SECTION("Packed node pages") {
+		using PNod = Node<PackedKeysConfig>;
+		std::vector<long> keys(200);
+		std::iota(keys.begin(), keys.end(), 1'650'000'000l);
+		auto node = PNod(PNod::Metadata(PNod::Leaf(std::vector<long>(keys), std::vector<int>(keys.size(), 42))), 13, PNod::RootStatus::IsInternal);
+		REQUIRE(PNod::from_page(node.make_page()) == node);
+		REQUIRE(node.encoded_size() < nop::Encoding<PNod>::Size(node));
+
+		auto branch = PNod(PNod::Metadata(PNod::Branch({1, 2}, {4096, 8192, 12288}, {LinkStatus::Valid, LinkStatus::Valid, LinkStatus::Valid})), 0, PNod::RootStatus::IsRoot);
+		REQUIRE(PNod::from_page(branch.make_page()) == branch);
+	}
+}
+
+template<>
+struct internal::storage::btree::Columns<person> {
+	static constexpr auto fields = std::make_tuple(&person::name, &person::age, &person::email);
+};
+
+struct ColumnarConfig : Config {
+	using Val = person;
+	using RealVal = person;
+	static inline constexpr bool COLUMNAR_LEAVES = true;
+};
+
+TEST_CASE("Columnar leaves", "[btree]") {
+	using CNod = Node<ColumnarConfig>;
+	static_assert(CNod::COLUMNAR_LEAVES);
+	static_assert(!Node<Config>::COLUMNAR_LEAVES);
+
+	auto keys = n_random_items<int>(100);
+	auto vals = n_random_items<person>(100);
+	auto node = CNod(CNod::Metadata(CNod::Leaf(std::vector<int>(keys), std::vector<person>(vals))), 13, CNod::RootStatus::IsInternal);
+	node.set_next_node(8192);
+	const auto page = node.make_page();
+	REQUIRE(CNod::from_page(page) == node);
+
+	const auto ages = CNod::read_column<&person::age>(page);
+	REQUIRE(ages.has_value());
+	REQUIRE(ages->keys == keys);
+	REQUIRE(ages->next_node == Position(8192));
+	for (std::size_t i = 0; i < vals.size(); ++i)
+		REQUIRE(ages->column[i] == vals[i].age);
+
+	const auto emails = CNod::read_column<&person::email>(page);
+	for (std::size_t i = 0; i < vals.size(); ++i)
+		REQUIRE(emails->column[i] == vals[i].email);
+
+	auto branch = CNod(CNod::Metadata(CNod::Branch({1}, {4096, 8192}, {LinkStatus::Valid, LinkStatus::Valid})), 0, CNod::RootStatus::IsRoot);
+	REQUIRE(CNod::from_page(branch.make_page()) == branch);
+	REQUIRE_FALSE(CNod::read_column<&person::age>(branch.make_page()).has_value());
+
+	/// Columns which do not fit in the page are reported instead of being written over each other
+	auto big = CNod(CNod::Metadata(CNod::Leaf(n_random_items<int>(1000), n_random_items<person>(1000))), 13, CNod::RootStatus::IsInternal);
+	REQUIRE_FALSE(big.fits_in_page());
+	REQUIRE_THROWS_AS(big.make_page(), BadWrite);
+}
+
 TEST_CASE("Persistent nodes", "[btree]") {
 	Pager pr("/tmp/eu-persistent-nodes-pager");
 
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <numeric>
 #include <optional>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -54,6 +59,71 @@ enum class SplitBias { LeanLeft,
 enum class SplitType { ExplodeOnly,
 	               ExcludeMid };
 
+/// Frame-of-reference encoding of sorted integral keys
+/// The keys are stored as differences from the smallest one ('base'), each of them taking exactly 'width' bits.
+/// Dense ranges of keys (IDs, timestamps) need only a few bits per key instead of sizeof(Key) bytes.
+/// One additional word is kept at the end, so that unpacking never has to check whether a key crosses a word boundary.
+template<std::integral Key>
+struct PackedKeys {
+	using UKey = std::make_unsigned_t<Key>;
+
+	Key base{};
+	uint8_t width{0};
+	uint32_t count{0};
+	std::vector<uint64_t> words;
+
+	[[nodiscard]] static PackedKeys pack(const std::vector<Key> &keys) {
+		PackedKeys packed;
+		if (keys.empty())
+			return packed;
+
+		packed.base = keys.front();
+		packed.count = keys.size();
+		packed.width = std::bit_width(static_cast<UKey>(static_cast<UKey>(keys.back()) - static_cast<UKey>(packed.base)));
+		/// The last key is followed by a padding word, even if all keys are equal and take no bits at all.
+		packed.words.resize(packed.count * packed.width / 64 + 2);
+
+		for (std::size_t i = 0; i < keys.size(); ++i) {
+			const uint64_t delta = static_cast<UKey>(static_cast<UKey>(keys[i]) - static_cast<UKey>(packed.base));
+			const std::size_t bit = i * packed.width;
+			packed.words[bit / 64] |= delta << (bit % 64);
+			/// Shifting in two steps keeps the shift amount below 64 when the key does not cross the boundary.
+			packed.words[bit / 64 + 1] |= (delta >> 1) >> (63 - bit % 64);
+		}
+		return packed;
+	}
+
+	/// The loop is branch-free - every key is assembled from two adjacent words, whether it crosses their boundary or not.
+	[[nodiscard]] std::vector<Key> unpack() const {
+		std::vector<Key> keys(count);
+		const uint64_t mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+		const auto ubase = static_cast<UKey>(base);
+		const uint64_t *w = words.data();
+		for (std::size_t i = 0; i < count; ++i) {
+			const std::size_t bit = i * width;
+			const uint64_t lo = w[bit / 64] >> (bit % 64);
+			const uint64_t hi = (w[bit / 64 + 1] << 1) << (63 - bit % 64);
+			keys[i] = static_cast<Key>(static_cast<UKey>(ubase + static_cast<UKey>((lo | hi) & mask)));
+		}
+		return keys;
+	}
+
+	NOP_STRUCTURE(PackedKeys, base, width, count, words);
+};
+
+/// Fields of a value type which are stored column by column in leaves (see 'Config::COLUMNAR_LEAVES')
+/// Specialize it with a tuple of member pointers named 'fields', listing all fields of the type in order, e.g
+///     template<>
+///     struct Columns<person> {
+///         static constexpr auto fields = std::make_tuple(&person::name, &person::age, &person::email);
+///     };
+/// The value type is reconstructed from its columns by default-constructing it and assigning each of its fields.
+template<typename T>
+struct Columns;
+
+template<typename T>
+concept ColumnarValue = requires { std::tuple_size<std::remove_cvref_t<decltype(Columns<T>::fields)>>::value; };
+
 template<EugeneConfig Config = Config>
 class Node {
 	friend Btree<Config>;
@@ -66,6 +136,21 @@ class Node {
 	using Ref = typename Config::Ref;
 
 public:
+	/// Expiration time of an entry in milliseconds since the epoch, 0 meaning that it never expires.
+	/// See 'Config::TTL_ENTRIES'.
+	using Expiry = uint64_t;
+
+	static constexpr bool TTL_ENTRIES = Config::TTL_ENTRIES;
+
+	[[nodiscard]] static Expiry now() noexcept {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	/// Expiration time of an entry with lifetime 'ttl' which starts now
+	[[nodiscard]] static Expiry expiry_after(const std::chrono::milliseconds ttl) noexcept {
+		return ttl.count() > 0 ? now() + ttl.count() : 0;
+	}
+
 	///
 	/// Node types
 	///
@@ -104,17 +189,24 @@ public:
 		[[nodiscard]] auto operator<=>(const Entry &) const noexcept = default;
 	};
 
+	/// With 'TTL_ENTRIES', 'expiry' holds the expiration time of each entry, otherwise it is empty.
+	/// The expiration times are not part of the encoding of the leaf, see 'TtlLeaf'.
 	struct Leaf {
 		std::vector<Key> keys;
 		std::vector<Val> vals;
+		std::vector<Expiry> expiry;
 
 		constexpr Leaf() = default;
-		constexpr Leaf(std::vector<Key> &&keys, std::vector<Val> &&vals)
-		    : keys{std::move(keys)}, vals{std::move(vals)} {}
+		constexpr Leaf(std::vector<Key> &&keys, std::vector<Val> &&vals, std::vector<Expiry> &&expiry = {})
+		    : keys{std::move(keys)}, vals{std::move(vals)}, expiry{std::move(expiry)} {}
 
 		constexpr Leaf(const Leaf &) = default;
 		constexpr Leaf &operator=(const Leaf &) = default;
 
+		[[nodiscard]] bool is_expired(const std::size_t idx, const Expiry now) const noexcept {
+			return idx < expiry.size() && expiry[idx] != 0 && expiry[idx] <= now;
+		}
+
 		auto operator<=>(const Leaf &) const noexcept = default;
 		NOP_STRUCTURE(Leaf, keys, vals);
 	};
@@ -122,6 +214,136 @@ public:
 	/// Each node contains either a Branch or Leaf specific data.
 	using Metadata = nop::Variant<Branch, Leaf>;
 
+	/// Delta record
+	/// Describes a change of a single entry of a leaf, which is appended to the leaf page instead of
+	/// rewriting the whole node. See 'Config::LEAF_DELTA_CHAIN'.
+	enum class DeltaKind : uint8_t { Insert,
+		                         Update,
+		                         Remove };
+
+	struct Delta {
+		DeltaKind kind;
+		Key key;
+		nop::Optional<Val> val;
+		Expiry expiry{0};
+
+		NOP_STRUCTURE(Delta, kind, key, val);
+	};
+
+	/// Page representation of a node when using 'TTL_ENTRIES'
+	/// Only trees with expiring entries store their expiration times, the pages of the others keep the layout of 'Leaf'.
+	struct TtlLeaf {
+		std::vector<Key> keys;
+		std::vector<Val> vals;
+		std::vector<Expiry> expiry;
+		NOP_STRUCTURE(TtlLeaf, keys, vals, expiry);
+	};
+
+	struct TtlNode {
+		nop::Variant<Branch, TtlLeaf> metadata;
+		bool is_root;
+		Position parent_pos;
+		nop::Optional<Position> next_node_pos;
+		NOP_STRUCTURE(TtlNode, metadata, is_root, parent_pos, next_node_pos);
+	};
+
+	struct TtlDelta {
+		DeltaKind kind;
+		Key key;
+		nop::Optional<Val> val;
+		Expiry expiry;
+		NOP_STRUCTURE(TtlDelta, kind, key, val, expiry);
+	};
+
+	/// Whether leaf pages carry a delta chain.
+	/// In such case the tail of the page ('Config::LEAF_DELTA_AREA' bytes) is reserved for it and the node
+	/// itself is stored in the rest. The chain starts with its length and the number of bytes it occupies.
+	static constexpr bool DELTA_CHAINS = Config::LEAF_DELTA_CHAIN > 0;
+	static constexpr std::size_t NODE_AREA_SIZE = DELTA_CHAINS ? PAGE_SIZE - Config::LEAF_DELTA_AREA : PAGE_SIZE;
+	static constexpr std::size_t DELTA_CHAIN_HEADER_SIZE = 2 * sizeof(uint16_t);
+
+	/// Whether leaves are stored with packed keys (see 'PackedKeys' and 'Config::PACK_LEAF_KEYS').
+	/// Nodes are the same in memory, only their page representation differs.
+	static constexpr bool PACKED_KEYS = Config::PACK_LEAF_KEYS && std::integral<Key>;
+
+	/// Page representation of a node when using 'PACKED_KEYS'
+	struct PackedLeaf {
+		PackedKeys<Key> keys;
+		std::vector<Val> vals;
+		NOP_STRUCTURE(PackedLeaf, keys, vals);
+	};
+
+	struct PackedTtlLeaf {
+		PackedKeys<Key> keys;
+		std::vector<Val> vals;
+		std::vector<Expiry> expiry;
+		NOP_STRUCTURE(PackedTtlLeaf, keys, vals, expiry);
+	};
+
+	using PackedLeafPage = std::conditional_t<TTL_ENTRIES, PackedTtlLeaf, PackedLeaf>;
+
+	struct PackedNode {
+		nop::Variant<Branch, PackedLeafPage> metadata;
+		bool is_root;
+		Position parent_pos;
+		nop::Optional<Position> next_node_pos;
+		NOP_STRUCTURE(PackedNode, metadata, is_root, parent_pos, next_node_pos);
+	};
+
+	/// Whether leaves are stored in columnar (PAX) layout (see 'Columns' and 'Config::COLUMNAR_LEAVES').
+	/// Nodes are the same in memory. In their pages though, each field of the values is placed in its own contiguous
+	/// column at the end of the node area, and the node only contains the offsets of the columns. This allows reading
+	/// the keys and a single column of a leaf without decoding the rest of the values.
+	static constexpr bool COLUMNAR_LEAVES = [] {
+		if constexpr (ColumnarValue<Val>)
+			return Config::COLUMNAR_LEAVES;
+		return false;
+	}();
+	static_assert(!(PACKED_KEYS && COLUMNAR_LEAVES), "Eugene: packed keys and columnar leaves could not be combined");
+
+	/// Page representation of a node when using 'COLUMNAR_LEAVES'
+	struct ColumnarLeaf {
+		std::vector<Key> keys;
+		std::vector<uint16_t> column_offsets;
+		std::vector<uint16_t> column_sizes;
+		NOP_STRUCTURE(ColumnarLeaf, keys, column_offsets, column_sizes);
+	};
+
+	struct ColumnarTtlLeaf {
+		std::vector<Key> keys;
+		std::vector<uint16_t> column_offsets;
+		std::vector<uint16_t> column_sizes;
+		std::vector<Expiry> expiry;
+		NOP_STRUCTURE(ColumnarTtlLeaf, keys, column_offsets, column_sizes, expiry);
+	};
+
+	using ColumnarLeafPage = std::conditional_t<TTL_ENTRIES, ColumnarTtlLeaf, ColumnarLeaf>;
+
+	struct ColumnarNode {
+		nop::Variant<Branch, ColumnarLeafPage> metadata;
+		bool is_root;
+		Position parent_pos;
+		nop::Optional<Position> next_node_pos;
+		NOP_STRUCTURE(ColumnarNode, metadata, is_root, parent_pos, next_node_pos);
+	};
+
+	/// Type of the field stored in the column 'Field' when using 'COLUMNAR_LEAVES'
+	template<auto Field>
+	using ColumnType = std::remove_cvref_t<decltype(std::declval<Val &>().*Field)>;
+
+	/// Keys and a single column of a leaf
+	template<auto Field>
+	struct ColumnSlice {
+		std::vector<Key> keys;
+		std::vector<ColumnType<Field>> column;
+		std::vector<Expiry> expiry;
+		std::optional<Position> next_node;
+
+		[[nodiscard]] bool is_expired(const std::size_t idx, const Expiry now) const noexcept {
+			return idx < expiry.size() && expiry[idx] != 0 && expiry[idx] <= now;
+		}
+	};
+
 	/// Metadata "constructor"
 	template<typename NodeType, typename... T>
 	constexpr static auto metadata_ctor(T &&...ctor_args) {
@@ -164,21 +386,171 @@ public:
 		{}
 			// throw BadRead("cannot create node from page");
 			// throw BadRead();
-		nop::Deserializer<nop::BufferReader> deserializer{p.data() + 1, PAGE_SIZE - 1};
+		nop::Deserializer<nop::BufferReader> deserializer{p.data() + 1, NODE_AREA_SIZE - 1};
 		Node node;
-		deserializer.Read(&node);
+		if constexpr (PACKED_KEYS) {
+			PackedNode packed;
+			deserializer.Read(&packed);
+			node = unpacked(std::move(packed));
+		} else if constexpr (COLUMNAR_LEAVES) {
+			ColumnarNode columnar;
+			deserializer.Read(&columnar);
+			node = from_columns(p, std::move(columnar));
+		} else if constexpr (TTL_ENTRIES) {
+			TtlNode ttl;
+			deserializer.Read(&ttl);
+			node = from_ttl(std::move(ttl));
+		} else {
+			deserializer.Read(&node);
+		}
+		if constexpr (DELTA_CHAINS)
+			node.replay_deltas(p);
 		return node;
 	}
 
 	/// Create a page containing this' data
-	[[nodiscard]] constexpr Page make_page() const noexcept {
+	/// The delta chain of the page, if any, is empty - the node already contains all changes.
+	/// 'BadWrite' is thrown if the columns of a leaf do not fit in the page.
+	[[nodiscard]] constexpr Page make_page() const noexcept(!COLUMNAR_LEAVES) {
 		Page p;
 		p[0] = static_cast<uint8_t>(PageType::Node);
-		nop::Serializer<nop::BufferWriter> serializer{p.data() + 1, PAGE_SIZE - 1};
-		serializer.Write(*this);
+		if constexpr (COLUMNAR_LEAVES) {
+			/// The columns are placed right before the end of the node area and the node itself - right after the page type.
+			auto columnar = to_columns(&p);
+			nop::Serializer<nop::BufferWriter> serializer{p.data() + 1, columnar_node_end(columnar) - 1};
+			if (!serializer.Write(columnar))
+				throw BadWrite("leaf does not fit in its page");
+		} else {
+			nop::Serializer<nop::BufferWriter> serializer{p.data() + 1, NODE_AREA_SIZE - 1};
+			if constexpr (PACKED_KEYS)
+				serializer.Write(packed());
+			else if constexpr (TTL_ENTRIES)
+				serializer.Write(to_ttl());
+			else
+				serializer.Write(*this);
+		}
+		if constexpr (DELTA_CHAINS)
+			set_delta_chain_header(p, 0, 0);
 		return p;
 	}
 
+	/// Number of bytes the node takes in its page
+	[[nodiscard]] std::size_t encoded_size() const {
+		if constexpr (PACKED_KEYS) {
+			return nop::Encoding<PackedNode>::Size(packed());
+		} else if constexpr (COLUMNAR_LEAVES) {
+			const auto columnar = to_columns();
+			std::size_t columns_size = 0;
+			if (const auto *l = columnar.metadata.template get<ColumnarLeafPage>())
+				columns_size = std::accumulate(l->column_sizes.begin(), l->column_sizes.end(), std::size_t{0});
+			return nop::Encoding<ColumnarNode>::Size(columnar) + columns_size;
+		} else if constexpr (TTL_ENTRIES) {
+			return nop::Encoding<TtlNode>::Size(to_ttl());
+		} else {
+			return nop::Encoding<Node>::Size(*this);
+		}
+	}
+
+	/// Read the keys and a single column of the leaf stored in a page, without decoding the other fields of its values
+	/// Returns an empty optional if the page contains a branch node.
+	template<auto Field>
+	requires COLUMNAR_LEAVES
+	[[nodiscard]] static std::optional<ColumnSlice<Field>> read_column(const Page &p) {
+		/// Pending deltas contain whole values, thus the leaf is decoded as a whole.
+		if constexpr (DELTA_CHAINS) {
+			if (delta_chain_header(p).first > 0) {
+				auto node = from_page(p);
+				if (!node.is_leaf())
+					return {};
+				ColumnSlice<Field> slice{.keys = std::move(node.leaf().keys), .column = {}, .expiry = std::move(node.leaf().expiry), .next_node = node.next_node()};
+				slice.column.reserve(node.leaf().vals.size());
+				for (const auto &val : node.leaf().vals)
+					slice.column.push_back(val.*Field);
+				return slice;
+			}
+		}
+
+		ColumnarNode columnar;
+		nop::Deserializer<nop::BufferReader> deserializer{p.data() + 1, NODE_AREA_SIZE - 1};
+		if (!deserializer.Read(&columnar))
+			throw BadRead("failed reading columnar node");
+		auto *l = columnar.metadata.template get<ColumnarLeafPage>();
+		if (!l)
+			return {};
+
+		ColumnSlice<Field> slice;
+		read_column_at(p, *l, column_index<Field>(), slice.column);
+		slice.keys = std::move(l->keys);
+		if constexpr (TTL_ENTRIES)
+			slice.expiry = std::move(l->expiry);
+		if (columnar.next_node_pos)
+			slice.next_node = columnar.next_node_pos.get();
+		return slice;
+	}
+
+	/// Whether the node could be placed in a single page
+	[[nodiscard]] bool fits_in_page() const { return encoded_size() <= NODE_AREA_SIZE - 1; }
+
+	/// Append a delta record to the chain of a page made by 'make_page'
+	/// Only the bytes of the record and the chain header are touched. Returns false if the chain is full, in
+	/// which case the caller has to fold it, i.e to place the node using 'make_page'.
+	[[nodiscard]] static bool append_delta(Page &p, const Delta &delta) {
+		if constexpr (!DELTA_CHAINS)
+			return false;
+
+		const auto append = [&p](const auto &record) {
+			using Record = std::remove_cvref_t<decltype(record)>;
+			const auto [length, used] = delta_chain_header(p);
+			const std::size_t delta_size = nop::Encoding<Record>::Size(record);
+			if (length >= Config::LEAF_DELTA_CHAIN || DELTA_CHAIN_HEADER_SIZE + used + delta_size > Config::LEAF_DELTA_AREA)
+				return false;
+
+			nop::Serializer<nop::BufferWriter> serializer{p.data() + NODE_AREA_SIZE + DELTA_CHAIN_HEADER_SIZE + used, delta_size};
+			if (!serializer.Write(record))
+				return false;
+			set_delta_chain_header(p, length + 1, used + delta_size);
+			return true;
+		};
+
+		if constexpr (TTL_ENTRIES)
+			return append(TtlDelta{.kind = delta.kind, .key = delta.key, .val = delta.val, .expiry = delta.expiry});
+		else
+			return append(delta);
+	}
+
+	/// Apply a delta record to a leaf
+	void apply_delta(Delta &&delta) {
+		auto &l = leaf();
+		const auto it = std::lower_bound(l.keys.cbegin(), l.keys.cend(), delta.key);
+		const auto idx = std::distance(l.keys.cbegin(), it);
+		const bool found = it != l.keys.cend() && *it == delta.key;
+
+		// clang-format off
+		switch (delta.kind) {
+			break; case DeltaKind::Insert:
+				if (found)
+					throw BadRead(fmt::format("delta inserts present key '{}'", delta.key));
+				l.vals.insert(l.vals.cbegin() + idx, std::move(delta.val.get()));
+				l.keys.insert(it, std::move(delta.key));
+				if constexpr (TTL_ENTRIES)
+					l.expiry.insert(l.expiry.cbegin() + idx, delta.expiry);
+			break; case DeltaKind::Update:
+				if (!found)
+					throw BadRead(fmt::format("delta updates missing key '{}'", delta.key));
+				l.vals[idx] = std::move(delta.val.get());
+				if constexpr (TTL_ENTRIES)
+					l.expiry[idx] = delta.expiry;
+			break; case DeltaKind::Remove:
+				if (!found)
+					throw BadRead(fmt::format("delta removes missing key '{}'", delta.key));
+				l.vals.erase(l.vals.cbegin() + idx);
+				l.keys.erase(it);
+				if constexpr (TTL_ENTRIES)
+					l.expiry.erase(l.expiry.cbegin() + idx);
+		}
+		// clang-format on
+	}
+
 	/// Perform a split operation based on some branching factor 'm'.
 	/// Returns a brand new node and the key which is not contained in
 	/// neither of the nodes. It should be put in the parent's list.
@@ -209,6 +581,8 @@ public:
 		} else {
 			auto &l = leaf();
 			sibling = {metadata_ctor<Leaf>(break_at_index(l.keys, pivot), break_at_index(l.vals, pivot)), parent()};
+			if constexpr (TTL_ENTRIES)
+				sibling.leaf().expiry = break_at_index(l.expiry, pivot);
 			midkey = sibling.leaf().keys.front();
 		}
 
@@ -227,10 +601,14 @@ public:
 					// fmt::print("Adding {}\n", *(leaf().keys.cbegin() + idx));
 					l.keys.push_back(*(leaf().keys.cbegin() + idx));
 					l.vals.push_back(*(leaf().vals.cbegin() + idx));
+					if constexpr (TTL_ENTRIES)
+						l.expiry.push_back(*(leaf().expiry.cbegin() + idx));
 				} else {
 					// fmt::print("Adding {}\n", *(other.leaf().keys.cbegin() + idx));
 					l.keys.push_back(*(other.leaf().keys.cbegin() + idx));
 					l.vals.push_back(*(other.leaf().vals.cbegin() + idx));
+					if constexpr (TTL_ENTRIES)
+						l.expiry.push_back(*(other.leaf().expiry.cbegin() + idx));
 				}
 			});
 			m = l;
@@ -324,6 +702,214 @@ public:
 
 	void set_next_node(Position pos) noexcept { m_next_node_pos = pos; }
 
+	void clear_next_node() noexcept { m_next_node_pos.clear(); }
+
+private:
+	///
+	/// Packed keys
+	///
+
+	[[nodiscard]] PackedNode packed() const {
+		PackedNode packed{.metadata = {}, .is_root = m_is_root, .parent_pos = m_parent_pos, .next_node_pos = m_next_node_pos};
+		if (is_leaf()) {
+			PackedLeafPage l{.keys = PackedKeys<Key>::pack(leaf().keys), .vals = leaf().vals};
+			if constexpr (TTL_ENTRIES)
+				l.expiry = leaf().expiry;
+			packed.metadata = std::move(l);
+		} else
+			packed.metadata = branch();
+		return packed;
+	}
+
+	[[nodiscard]] static Node unpacked(PackedNode &&packed) {
+		Node node;
+		if (auto *l = packed.metadata.template get<PackedLeafPage>()) {
+			std::vector<Expiry> expiry;
+			if constexpr (TTL_ENTRIES)
+				expiry = std::move(l->expiry);
+			node.m_metadata = Leaf(l->keys.unpack(), std::move(l->vals), std::move(expiry));
+		} else
+			node.m_metadata = std::move(*packed.metadata.template get<Branch>());
+		node.m_is_root = packed.is_root;
+		node.m_parent_pos = packed.parent_pos;
+		node.m_next_node_pos = packed.next_node_pos;
+		return node;
+	}
+
+	///
+	/// Columnar leaves
+	///
+
+	static constexpr std::size_t NUM_COLUMNS = []() -> std::size_t {
+		if constexpr (COLUMNAR_LEAVES)
+			return std::tuple_size_v<std::remove_cvref_t<decltype(Columns<Val>::fields)>>;
+		return 0;
+	}();
+
+	template<auto Field>
+	[[nodiscard]] static constexpr std::size_t column_index() {
+		std::size_t idx = NUM_COLUMNS;
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			(([&] {
+				 if constexpr (std::is_same_v<std::remove_cvref_t<decltype(std::get<I>(Columns<Val>::fields))>, decltype(Field)>)
+					 if (std::get<I>(Columns<Val>::fields) == Field)
+						 idx = I;
+			 }()),
+			 ...);
+		}(std::make_index_sequence<NUM_COLUMNS>{});
+		return idx;
+	}
+
+	/// Create the page representation of the node. If 'p' is given, the columns of a leaf are written into it.
+	[[nodiscard]] ColumnarNode to_columns(Page *p = nullptr) const {
+		ColumnarNode columnar{.metadata = {}, .is_root = m_is_root, .parent_pos = m_parent_pos, .next_node_pos = m_next_node_pos};
+		if (is_branch()) {
+			columnar.metadata = branch();
+			return columnar;
+		}
+
+		ColumnarLeafPage l{.keys = leaf().keys, .column_offsets = {}, .column_sizes = {}};
+		if constexpr (TTL_ENTRIES)
+			l.expiry = leaf().expiry;
+		std::size_t end = NODE_AREA_SIZE;
+		[&]<std::size_t... I>(std::index_sequence<I...>) {
+			(([&] {
+				 constexpr auto field = std::get<I>(Columns<Val>::fields);
+				 std::vector<ColumnType<field>> column;
+				 column.reserve(leaf().vals.size());
+				 for (const auto &val : leaf().vals)
+					 column.push_back(val.*field);
+
+				 const std::size_t size = nop::Encoding<decltype(column)>::Size(column);
+				 /// The columns have to leave room for the page type, at least.
+				 if (size >= end) {
+					 if (p)
+						 throw BadWrite("columns of the leaf do not fit in its page");
+					 /// Only the size of the node is needed, which then exceeds the node area (see 'encoded_size').
+					 end = 0;
+				 } else {
+					 end -= size;
+				 }
+				 l.column_offsets.push_back(end);
+				 l.column_sizes.push_back(size);
+				 if (p) {
+					 nop::Serializer<nop::BufferWriter> serializer{p->data() + end, size};
+					 serializer.Write(column);
+				 }
+			 }()),
+			 ...);
+		}(std::make_index_sequence<NUM_COLUMNS>{});
+		columnar.metadata = std::move(l);
+		return columnar;
+	}
+
+	[[nodiscard]] static std::size_t columnar_node_end(const ColumnarNode &columnar) {
+		if (const auto *l = columnar.metadata.template get<ColumnarLeafPage>(); l && !l->column_offsets.empty())
+			return l->column_offsets.back();
+		return NODE_AREA_SIZE;
+	}
+
+	template<typename T>
+	static void read_column_at(const Page &p, const ColumnarLeafPage &l, const std::size_t idx, std::vector<T> &column) {
+		if (idx >= l.column_offsets.size() || l.column_offsets[idx] + l.column_sizes[idx] > NODE_AREA_SIZE)
+			throw BadRead("corrupted columnar leaf");
+		nop::Deserializer<nop::BufferReader> deserializer{p.data() + l.column_offsets[idx], l.column_sizes[idx]};
+		if (!deserializer.Read(&column) || column.size() != l.keys.size())
+			throw BadRead("failed reading leaf column");
+	}
+
+	[[nodiscard]] static Node from_columns(const Page &p, ColumnarNode &&columnar) {
+		Node node;
+		if (auto *l = columnar.metadata.template get<ColumnarLeafPage>()) {
+			std::vector<Val> vals(l->keys.size());
+			[&]<std::size_t... I>(std::index_sequence<I...>) {
+				(([&] {
+					 constexpr auto field = std::get<I>(Columns<Val>::fields);
+					 std::vector<ColumnType<field>> column;
+					 read_column_at(p, *l, I, column);
+					 for (std::size_t i = 0; i < column.size(); ++i)
+						 vals[i].*field = std::move(column[i]);
+				 }()),
+				 ...);
+			}(std::make_index_sequence<NUM_COLUMNS>{});
+			std::vector<Expiry> expiry;
+			if constexpr (TTL_ENTRIES)
+				expiry = std::move(l->expiry);
+			node.m_metadata = Leaf(std::move(l->keys), std::move(vals), std::move(expiry));
+		} else {
+			node.m_metadata = std::move(*columnar.metadata.template get<Branch>());
+		}
+		node.m_is_root = columnar.is_root;
+		node.m_parent_pos = columnar.parent_pos;
+		node.m_next_node_pos = columnar.next_node_pos;
+		return node;
+	}
+
+	///
+	/// Expiring entries
+	///
+
+	[[nodiscard]] TtlNode to_ttl() const {
+		TtlNode ttl{.metadata = {}, .is_root = m_is_root, .parent_pos = m_parent_pos, .next_node_pos = m_next_node_pos};
+		if (is_leaf())
+			ttl.metadata = TtlLeaf{.keys = leaf().keys, .vals = leaf().vals, .expiry = leaf().expiry};
+		else
+			ttl.metadata = branch();
+		return ttl;
+	}
+
+	[[nodiscard]] static Node from_ttl(TtlNode &&ttl) {
+		Node node;
+		if (auto *l = ttl.metadata.template get<TtlLeaf>())
+			node.m_metadata = Leaf(std::move(l->keys), std::move(l->vals), std::move(l->expiry));
+		else
+			node.m_metadata = std::move(*ttl.metadata.template get<Branch>());
+		node.m_is_root = ttl.is_root;
+		node.m_parent_pos = ttl.parent_pos;
+		node.m_next_node_pos = ttl.next_node_pos;
+		return node;
+	}
+
+	///
+	/// Delta chains
+	///
+
+	[[nodiscard]] static std::pair<uint16_t, uint16_t> delta_chain_header(const Page &p) noexcept {
+		uint16_t length, used;
+		std::memcpy(&length, p.data() + NODE_AREA_SIZE, sizeof(length));
+		std::memcpy(&used, p.data() + NODE_AREA_SIZE + sizeof(length), sizeof(used));
+		return {length, used};
+	}
+
+	static void set_delta_chain_header(Page &p, const uint16_t length, const uint16_t used) noexcept {
+		std::memcpy(p.data() + NODE_AREA_SIZE, &length, sizeof(length));
+		std::memcpy(p.data() + NODE_AREA_SIZE + sizeof(length), &used, sizeof(used));
+	}
+
+	/// Bring the node up to date with the delta chain stored in its page
+	void replay_deltas(const Page &p) {
+		const auto [length, used] = delta_chain_header(p);
+		if (length == 0)
+			return;
+		if (!is_leaf() || DELTA_CHAIN_HEADER_SIZE + used > Config::LEAF_DELTA_AREA)
+			throw BadRead("corrupted delta chain");
+
+		nop::Deserializer<nop::BufferReader> deserializer{p.data() + NODE_AREA_SIZE + DELTA_CHAIN_HEADER_SIZE, used};
+		for (uint16_t i = 0; i < length; ++i) {
+			if constexpr (TTL_ENTRIES) {
+				TtlDelta delta;
+				if (!deserializer.Read(&delta))
+					throw BadRead("corrupted delta record");
+				apply_delta(Delta{.kind = delta.kind, .key = std::move(delta.key), .val = std::move(delta.val), .expiry = delta.expiry});
+			} else {
+				Delta delta;
+				if (!deserializer.Read(&delta))
+					throw BadRead("corrupted delta record");
+				apply_delta(std::move(delta));
+			}
+		}
+	}
+
 private:
 	/// Data specific for the node's position - either Branch if internal, or Leaf- otherwise.
 	Metadata m_metadata{};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <vector>
+
+/// Block container format
+/// <br> <br>
+/// The input is split into blocks of the same size (except for the last one), which are compressed independently of
+/// each other, each with its own Huffman table. Thus both compression and decompression of the blocks can run in
+/// parallel. The blocks are followed by an index of their positions, so that the decompressor can find every block
+/// without decoding the ones before it.
+/// <ul>
+///     <li>header
+///         <ul>
+///             <li>(4 bytes) -> magic "EUBC"</li>
+///             <li>(1 byte) -> version of the format</li>
+///             <li>(4 bytes) -> size of the uncompressed blocks</li>
+///         </ul>
+///     </li>
+///     <li>blocks (see below)</li>
+///     <li>index (16 bytes per block)
+///         <ul>
+///             <li>(8 bytes) -> offset of the block in the container</li>
+///             <li>(4 bytes) -> size of the compressed block</li>
+///             <li>(4 bytes) -> size of the uncompressed block</li>
+///         </ul>
+///     </li>
+///     <li>trailer
+///         <ul>
+///             <li>(8 bytes) -> number of blocks</li>
+///             <li>(8 bytes) -> offset of the index in the container</li>
+///         </ul>
+///     </li>
+/// </ul>
+/// A block is a bit stream, most significant bit first, padded with zeros to a whole byte. It starts with its mode
+/// (8 bits, see BlockMode).
+/// <ul>
+///     <li>Huffman
+///         <ul>
+///             <li>(4 bits per byte value, 128 bytes) -> length of the code of each byte value, 0 if it is not used</li>
+///             <li>(bits) -> codes of the bytes in the block</li>
+///         </ul>
+///     </li>
+///     <li>LZ77, as in deflate - the bytes are replaced with literals and matches of earlier bytes of the block
+///         <ul>
+///             <li>(4 bits per symbol) -> lengths of the codes of the LiteralSymbols literal/length symbols, followed by
+///                 the ones of the DistanceSymbols distance symbols</li>
+///             <li>for each literal, the code of its byte value</li>
+///             <li>for each match, the code of its length symbol and the extra bits of its length (see LengthBase),
+///                 followed by the code of its distance symbol and the extra bits of its distance (see DistanceBase)</li>
+///         </ul>
+///     </li>
+///     <li>Stored - the bytes of the block as they are, for blocks which coding does not make smaller</li>
+/// </ul>
+/// The codes are canonical (see canonical_codes) and at most MaxCodeLength bits long, thus their lengths are enough to
+/// restore them. Blocks of version 3 are never stored, and blocks of version 2 have no mode, they are all Huffman blocks.
+/// In version 1 the block started with the number of symbols minus 1 (8 bits) and, for each symbol, the symbol (8 bits),
+/// the length of its code (8 bits) and the code itself.
+/// All numbers are little-endian.
+namespace compression::block {
+
+static constexpr std::array<uint8_t, 4> Magic = {'E', 'U', 'B', 'C'};
+static constexpr uint8_t Version = 4;
+static constexpr uint8_t MinVersion = 1;//!< oldest version which can still be decompressed
+
+static constexpr std::size_t HeaderSize = 9;
+static constexpr std::size_t IndexEntrySize = 16;
+static constexpr std::size_t TrailerSize = 16;
+
+static constexpr std::size_t DefaultBlockSize = 1024 * 1024;
+static constexpr std::size_t MaxBlockSize = 64 * 1024 * 1024;
+
+static constexpr unsigned MaxCodeLength = 15;
+static constexpr unsigned CodeLengthBits = 4;
+
+enum class BlockMode : uint8_t {
+	Huffman = 0,
+	LZ77 = 1,
+	Stored = 2,
+};
+
+/// LZ77 alphabets - literals are the byte values, followed by the length symbols
+static constexpr std::size_t LiteralSymbols = 256 + 29;
+static constexpr std::size_t DistanceSymbols = 30;
+
+static constexpr std::size_t MinMatch = 3;
+static constexpr std::size_t MaxMatch = 258;
+static constexpr std::size_t MaxWindow = 32 * 1024;
+
+/// Smallest match length of each length symbol, and the number of extra bits which are added to it
+static constexpr std::array<uint16_t, 29> LengthBase = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                                        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static constexpr std::array<uint8_t, 29> LengthExtraBits = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                                            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+/// Smallest match distance of each distance symbol, and the number of extra bits which are added to it
+static constexpr std::array<uint16_t, 30> DistanceBase = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                                          257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                                          8193, 12289, 16385, 24577};
+static constexpr std::array<uint8_t, 30> DistanceExtraBits = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                                              7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+struct IndexEntry {
+	uint64_t offset = 0;
+	uint32_t compressed_size = 0;
+	uint32_t raw_size = 0;
+};
+
+/// \brief Assigns the canonical codes to the symbols with code lengths 'lengths'
+/// Codes are given in order of their length, and of the symbols for the same length, each one being the previous
+/// code plus one, shifted left by the difference of their lengths.
+///
+/// \param assign - called with each used symbol, its code and the length of its code
+inline void canonical_codes(std::span<const uint8_t> lengths, auto &&assign) {
+	uint64_t code = 0;
+	unsigned prev_length = 0;
+	for (unsigned length = 1; length <= MaxCodeLength; ++length) {
+		for (unsigned symbol = 0; symbol < lengths.size(); ++symbol) {
+			if (lengths[symbol] != length)
+				continue;
+			code <<= length - prev_length;
+			prev_length = length;
+			assign((uint16_t) symbol, code, length);
+			++code;
+		}
+	}
+}
+
+inline void put_le(std::vector<uint8_t> &out, uint64_t val, std::size_t bytes) {
+	for (std::size_t i = 0; i < bytes; ++i, val >>= CHAR_BIT)
+		out.push_back(static_cast<uint8_t>(val));
+}
+
+inline uint64_t get_le(std::span<const uint8_t> in, std::size_t bytes) {
+	uint64_t val = 0;
+	for (std::size_t i = 0; i < bytes; ++i)
+		val |= static_cast<uint64_t>(in[i]) << (i * CHAR_BIT);
+	return val;
+}
+
+}// namespace compression::block
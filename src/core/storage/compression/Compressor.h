@@ -1,11 +1,28 @@
 #pragma once
 
+#include <atomic>
+#include <bit>
 #include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <numeric>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <core/Logger.h>
+#include <core/storage/compression/BlockFormat.h>
+#include <core/storage/compression/Directory.h>
 
 static constexpr size_t FileBits = 9;
 static constexpr size_t FileSizeBits = 64;
@@ -47,14 +64,202 @@ namespace fs = std::filesystem;
 ///         </ul>
 ///     </li>
 ///     <li>seventh (a lot of bits) -> transformed version of current input_file (IF FILE)</li>
+///     <li>eighth (bytes) -> central directory with the offsets of the files and folders (see Directory.h)</li>
 /// </ul>
 /// **1** groups from third to seventh will be written as much as file count in that folder <br>
 ///    (this is argument_count-1(argc-1) for the main folder) <br>
 /// **2** whenever we see a new folder we will write_from_ch (sixth) then start writing from third to seventh
 namespace compression {
 namespace storage::detail {
+
+/// \brief Writes the compressed stream, most significant bit first
+///
+/// Bits are gathered in a 64-bit accumulator, which is flushed 32 bits at a time into an output buffer of
+/// BufferSize bytes, and the buffer is written to the file once it is full. Without a file, the whole stream is kept
+/// in the buffer.
+class BitWriter {
+public:
+	static constexpr std::size_t BufferSize = 1024 * 1024;
+
+	BitWriter() = default;
+
+	explicit BitWriter(FILE *out) : m_out(out) {
+		m_buffer.reserve(BufferSize);
+	}
+
+	/// \brief Writes the n low bits of 'bits'
+	///
+	/// \param n - number of bits, at most 64
+	void put(uint64_t bits, unsigned n) {
+		if (n > 32) {
+			put(bits >> 32, n - 32);
+			n = 32;
+		}
+		if (n == 0)
+			return;
+		m_acc = (m_acc << n) | (bits & ((uint64_t{1} << n) - 1));
+		m_count += n;
+		if (m_count >= 32) {
+			m_count -= 32;
+			const auto word = static_cast<uint32_t>(m_acc >> m_count);
+			m_buffer.push_back(word >> 24);
+			m_buffer.push_back(word >> 16);
+			m_buffer.push_back(word >> 8);
+			m_buffer.push_back(word);
+			if (m_out && m_buffer.size() + 4 > BufferSize)
+				flush_buffer();
+		}
+	}
+
+	/// \brief Writes the remaining bits, padded with zeros to a whole byte, and everything buffered
+	void finish() {
+		while (m_count >= CHAR_BIT) {
+			m_count -= CHAR_BIT;
+			m_buffer.push_back(m_acc >> m_count);
+		}
+		if (m_count > 0)
+			m_buffer.push_back(m_acc << (CHAR_BIT - m_count));
+		m_count = 0;
+		if (m_out)
+			flush_buffer();
+	}
+
+	/// \brief Number of bits written so far
+	uint64_t position() const {
+		return (m_flushed + m_buffer.size()) * CHAR_BIT + m_count;
+	}
+
+	/// \brief The stream written without a file, once it is finished
+	std::vector<uint8_t> take() {
+		return std::move(m_buffer);
+	}
+
+private:
+	void flush_buffer() {
+		fwrite(m_buffer.data(), 1, m_buffer.size(), m_out);
+		m_flushed += m_buffer.size();
+		m_buffer.clear();
+	}
+
+	FILE *m_out = nullptr;
+	std::vector<uint8_t> m_buffer;
+	uint64_t m_flushed = 0;//!< number of bytes written to the file
+
+	uint64_t m_acc = 0;   //!< the last m_count bits are not written yet
+	unsigned m_count = 0;
+};
+
+/// \brief Huffman code of a symbol - its 'length' low bits, the first one being the most significant
+struct HuffCode {
+	uint64_t bits = 0;
+	unsigned length = 0;
+};
+
+/// \brief Read-only mapping of a whole file
+class MappedFile {
+public:
+	explicit MappedFile(const std::string &path) {
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return;
+		struct stat info {};
+		if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+			void *data = mmap(nullptr, (std::size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				m_data = data;
+				m_size = (std::size_t) info.st_size;
+				madvise(m_data, m_size, MADV_SEQUENTIAL);
+			}
+		}
+		close(fd);
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	~MappedFile() {
+		if (m_data)
+			munmap(m_data, m_size);
+	}
+
+	/// \brief Whether the file is mapped - empty and special files are not
+	[[nodiscard]] bool mapped() const noexcept { return m_data != nullptr; }
+
+	[[nodiscard]] std::string_view view() const noexcept { return {static_cast<const char *>(m_data), m_size}; }
+
+private:
+	void *m_data = nullptr;
+	std::size_t m_size = 0;
+};
+
 class CompressorInternal {
 public:
+	static constexpr std::size_t BlockSize = 1024 * 1024;
+
+	/// \brief An input file or folder, in the order in which it is written to the compressed file
+	struct Input {
+		std::string path;
+		std::string name;            //!< name as it is written to the compressed file
+		bool is_file = false;
+		uint64_t size = 0;
+		unsigned long file_count = 0;//!< number of files and folders right inside a folder
+	};
+
+	/// \brief Passes the file in blocks of at most BlockSize bytes
+	/// The file is mapped, so it is not copied and its pages are dropped by the kernel once they are processed. Files
+	/// which cannot be mapped are read in blocks, so that memory usage does not depend on their size either.
+	///
+	/// \param path - string that represents the path to the file
+	/// \param process - called with each block, as a std::string_view
+	static void for_each_block(const std::string &path, auto &&process) {
+		if (const MappedFile file{path}; file.mapped()) {
+			const auto view = file.view();
+			for (std::size_t begin = 0; begin < view.size(); begin += BlockSize)
+				process(view.substr(begin, BlockSize));
+			return;
+		}
+
+		std::ifstream in(path, std::ifstream::binary);
+		std::string block(BlockSize, 0);
+		while (in) {
+			in.read(block.data(), (long) block.size());
+			if (const auto read = in.gcount(); read > 0)
+				process(std::string_view{block.data(), (std::size_t) read});
+		}
+	}
+
+	/// \brief Adds the number of occurrences of each byte in 'block' to 'occurrence_symbol'
+	/// Bytes are loaded 8 at a time and each of them is counted in a sub-histogram of its own, so that runs of the same
+	/// byte do not wait for the previous increment of the same counter.
+	static void count_bytes(std::string_view block, std::array<long int, 256> &occurrence_symbol) {
+		/// 32-bit counters keep the sub-histograms in 8KB of cache; they are added up before they can overflow.
+		static constexpr std::size_t MaxChunk = UINT32_MAX;
+
+		for (std::size_t begin = 0; begin < block.size(); begin += MaxChunk) {
+			const auto chunk = block.substr(begin, MaxChunk);
+			std::array<std::array<uint32_t, 256>, sizeof(uint64_t)> counts{};
+			std::size_t i = 0;
+			for (; i + sizeof(uint64_t) <= chunk.size(); i += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, chunk.data() + i, sizeof(word));
+				counts[0][(uint8_t) word]++;
+				counts[1][(uint8_t) (word >> 8)]++;
+				counts[2][(uint8_t) (word >> 16)]++;
+				counts[3][(uint8_t) (word >> 24)]++;
+				counts[4][(uint8_t) (word >> 32)]++;
+				counts[5][(uint8_t) (word >> 40)]++;
+				counts[6][(uint8_t) (word >> 48)]++;
+				counts[7][(uint8_t) (word >> 56)]++;
+			}
+			for (; i < chunk.size(); ++i)
+				counts[0][(uint8_t) chunk[i]]++;
+
+			for (unsigned symbol = 0; symbol < occurrence_symbol.size(); ++symbol)
+				for (const auto &count : counts)
+					occurrence_symbol[symbol] += count[symbol];
+		}
+	}
+
 	static std::string return_file_info(const std::string &path) {
 		std::ifstream in(path, std::ifstream::binary);
 		std::string buff(fs::file_size(path), 0);
@@ -86,9 +291,9 @@ public:
 	}
 
 	void operator()() {
-		for (const auto &file : m_files) {
-			m_all_size += get_file_folder_size(file);
-		}
+		list_inputs();
+		for (const auto &input : m_inputs)
+			m_all_size += input.size;
 
 		Logger::the([this](spdlog::logger logger){
 		  logger.log(spdlog::level::info,
@@ -96,16 +301,13 @@ public:
 		       m_files.begin()->c_str(), m_all_size);
 		});
 
-		m_total_bits = FileCountBitsInsideCurrFolder + FileBits * m_files.size();
-		for (const auto &item : m_files) {
-			for (const char *c = item.c_str(); *c; c++)
-				m_occurrence_symbol[(uint8_t) *c]++;
-
-			if (fs::is_directory(item))
-				count_folder_bytes_freq(item);
-			else
-				count_file_bytes_freq(item);
+		m_total_bits = FileCountBitsInsideCurrFolder;
+		for (const auto &input : m_inputs) {
+			m_total_bits += FileBits + (input.is_file ? FileSizeBits : FileCountBitsInsideCurrFolder);
+			for (const auto &item : input.name)
+				m_occurrence_symbol[(uint8_t) item]++;
 		}
+		count_files_bytes_freq();
 
 		for (const auto &item : m_occurrence_symbol) {
 			if (item)
@@ -122,12 +324,15 @@ public:
 		});
 
 		m_compressed_fp = fopen(m_compressed_name.c_str(), "wb");
-		fwrite(&m_symbols, 1, 1, m_compressed_fp);
+		m_writer = BitWriter{m_compressed_fp};
+		write_from_ch(m_symbols);
 		m_total_bits += CHAR_BIT;
 
 		process();
 
 		all_file_write();
+		m_writer.finish();
+		write_directory();
 		fclose(m_compressed_fp);
 
 		Logger::the([comp_name = m_compressed_name](spdlog::logger logger){
@@ -146,7 +351,7 @@ public:
 		huff_trie *left{nullptr}, *right{nullptr}; //!< left and right nodes of the m_trie_root
 		uint8_t character; //!< associated character in the m_trie_root node
 		long int char_occurrence; //<! occurrences of the respective character
-		std::string bit; //<! bit that represents Huffman code of current character
+		HuffCode code; //<! Huffman code of current character
 
 		huff_trie() = default;
 
@@ -158,6 +363,7 @@ public:
 	};
 
 	std::vector<std::string> m_files;//!< path to the m_files for compress
+	std::vector<Input> m_inputs;     //!< m_files and everything inside the folders among them
 	FILE *m_compressed_fp = nullptr; //!< file pointer to the new created compressed file
 
 	std::array<long int, 256> m_occurrence_symbol;//!< long integer array that will contain
@@ -170,11 +376,13 @@ public:
 	unsigned long m_total_bits = 0;//!< count the compressed file size
 	unsigned long m_symbols = 0;   //!< count of the file or folder m_symbols
 
-	std::array<std::string, 256> m_char_huffbits;//!< transformation string
-	//!< is put to m_str_huffbits array to make the compression process more time efficient
+	std::array<HuffCode, 256> m_char_huffbits;//!< transformation code
+	//!< is put to m_char_huffbits array to make the compression process more time efficient
 
-	uint8_t m_current_byte = '\0';//!< uint8_t value that represents the m_current_byte
-	int m_current_bit_count = 0;        //!< integer value of m_current_bit_count
+	BitWriter m_writer;//!< writer of the compressed file
+
+	std::vector<directory::Entry> m_directory;                      //!< entries written so far
+	std::unordered_map<std::string, uint64_t> m_directory_folders;//!< position of each folder in m_directory
 
 	/// \brief First creates the base of trie(and then sorting them by ascending frequencies).
 	/// Then creates pointers that traverses through leaf's.
@@ -188,36 +396,42 @@ public:
 	/// the most used character is using least number of bits.
 	/// Specific number of bits we re going to use for that character is determined by weight distribution
 	void initialize_trie() {
-		huff_trie *e = m_trie.data();
-		for (unsigned long i = 0; i < m_occurrence_symbol.size(); ++i) {
-			if (m_occurrence_symbol[i]) {
+		build_trie(m_trie, m_occurrence_symbol, m_symbols);
+	}
+
+	/// \brief The trie of 'symbols' used symbols, with 'occurrence_symbol' occurrences of each byte
+	/// The leaves are the first 'symbols' nodes of the trie. See initialize_trie.
+	static void build_trie(std::vector<huff_trie> &trie, const std::array<long int, 256> &occurrence_symbol, unsigned long symbols) {
+		huff_trie *e = trie.data();
+		for (unsigned long i = 0; i < occurrence_symbol.size(); ++i) {
+			if (occurrence_symbol[i]) {
 				e->right = nullptr;
 				e->left = nullptr;
-				e->char_occurrence = m_occurrence_symbol[i];
+				e->char_occurrence = occurrence_symbol[i];
 				e->character = i;
 				e++;
 			}
 		}
-		std::sort(m_trie.begin(), m_trie.end() - (long) (m_symbols - 1));
+		std::sort(trie.begin(), trie.end() - (long) (symbols - 1));
 
-		huff_trie *min1 = m_trie.data();    //!< min1 and min2 represents nodes that has minimum weights
-		huff_trie *min2 = m_trie.data() + 1;//!< min1 and min2 represents nodes that has minimum weights
+		huff_trie *min1 = trie.data();    //!< min1 and min2 represents nodes that has minimum weights
+		huff_trie *min2 = trie.data() + 1;//!< min1 and min2 represents nodes that has minimum weights
 
-		huff_trie *not_leaf = m_trie.data() + m_symbols;//!< not_leaf is the pointer that
+		huff_trie *not_leaf = trie.data() + symbols;//!< not_leaf is the pointer that
 		//!< traverses through nodes that are not leaves
 
-		huff_trie *is_leaf = m_trie.data() + 2;//!< is_leaf is the pointer that traverses through leaves
-		huff_trie *curr = m_trie.data() + m_symbols;
+		huff_trie *is_leaf = trie.data() + 2;//!< is_leaf is the pointer that traverses through leaves
+		huff_trie *curr = trie.data() + symbols;
 
-		for (unsigned long i = 0; i < m_symbols - 1; i++) {
+		for (unsigned long i = 0; i < symbols - 1; i++) {
 			curr->char_occurrence = min1->char_occurrence + min2->char_occurrence;
 			curr->left = min1;
 			curr->right = min2;
-			min1->bit = "1";
-			min2->bit = "0";
+			min1->code = HuffCode{.bits = 1, .length = 1};
+			min2->code = HuffCode{.bits = 0, .length = 1};
 			curr++;
 
-			if (is_leaf >= m_trie.data() + m_symbols) {
+			if (is_leaf >= trie.data() + symbols) {
 				min1 = not_leaf;
 				not_leaf++;
 			} else {
@@ -230,7 +444,7 @@ public:
 				}
 			}
 
-			if (is_leaf >= m_trie.data() + m_symbols) {
+			if (is_leaf >= trie.data() + symbols) {
 				min2 = not_leaf;
 				not_leaf++;
 			} else if (not_leaf >= curr) {
@@ -246,61 +460,115 @@ public:
 				}
 			}
 		}
-		for (huff_trie *huff = m_trie.data() + m_symbols * 2 - 2; huff > m_trie.data() - 1; huff--) {
-			if (huff->left)
-				huff->left->bit.insert(huff->left->bit.begin(), huff->bit.begin(), huff->bit.end());
-			if (huff->right)
-				huff->right->bit.insert(huff->right->bit.begin(), huff->bit.begin(), huff->bit.end());
+		for (huff_trie *huff = trie.data() + symbols * 2 - 2; huff > trie.data() - 1; huff--) {
+			for (huff_trie *child : {huff->left, huff->right}) {
+				if (child) {
+					child->code.bits |= huff->code.bits << 1;
+					child->code.length += huff->code.length;
+				}
+			}
 		}
 	}
 
-	/// \brief Count usage frequency of bytes inside the file and store the information
-	/// in long integer massive
-	///
-	/// \param path - string that represents the path to the file
-	void count_file_bytes_freq(const std::string &path) {
-		m_total_bits += FileSizeBits;
-		const std::string buff = return_file_info(path);
-
-		for (const auto &item : buff)
-			m_occurrence_symbol[(uint8_t) item]++;
+	/// \brief Huffman codes of the bytes with 'occurrence_symbol' occurrences - unused bytes get no code
+	/// A lone used byte gets a code of one bit, so that every code can be decoded.
+	static std::array<HuffCode, 256> huffman_codes(const std::array<long int, 256> &occurrence_symbol) {
+		std::array<HuffCode, 256> codes{};
+		const auto symbols = (unsigned long) std::ranges::count_if(occurrence_symbol, [](long int n) { return n > 0; });
+		if (symbols == 0)
+			return codes;
+
+		std::vector<huff_trie> trie(symbols * 2 - 1);
+		build_trie(trie, occurrence_symbol, symbols);
+		for (auto it = trie.begin(); it < trie.begin() + (long) symbols; ++it)
+			codes[it->character] = it->code.length > 0 ? it->code : HuffCode{.bits = 0, .length = 1};
+		return codes;
 	}
 
-	/// \brief This function counts usage frequency of bytes inside a folder
-	///
-	/// \param path - string that represents the path to the folder
-	void count_folder_bytes_freq(std::string_view path) {
-		m_total_bits += FileCountBitsInsideCurrFolder;
-
-		for (const auto &entry : fs::recursive_directory_iterator(path)) {
-			std::string next_path = entry.path();
-			std::string curr_fdir_name = &next_path.substr(next_path.find_last_of('/'))[1];
-			if (curr_fdir_name[0] == '.')
+	/// \brief Lists the m_files, followed by everything inside the folders among them, with a single walk of each folder
+	/// Hidden files and folders are skipped, though not the contents of hidden folders.
+	void list_inputs() {
+		static constexpr std::size_t NoFolder = SIZE_MAX;
+
+		for (const auto &item : m_files) {
+			if (!fs::is_directory(item)) {
+				m_inputs.push_back({.path = item, .name = item, .is_file = true, .size = fs::file_size(item)});
 				continue;
+			}
 
-			m_total_bits += FileBits;
-			for (const auto &item : curr_fdir_name)
-				m_occurrence_symbol[(uint8_t) item]++;
+			/// Position in m_inputs of the folder at each depth of the walk
+			std::vector<std::size_t> folders{m_inputs.size()};
+			m_inputs.push_back({.path = item, .name = item});
+			for (auto it = fs::recursive_directory_iterator(item); it != fs::recursive_directory_iterator(); ++it) {
+				std::string next_path = it->path();
+				std::string curr_fdir_name = next_path.substr(next_path.find_last_of('/') + 1);
+				const bool hidden = curr_fdir_name[0] == '.';
+				const auto depth = (std::size_t) it.depth();
+				const auto parent = folders[depth];
+				if (it->is_directory()) {
+					folders.resize(depth + 2);
+					folders[depth + 1] = hidden ? NoFolder : m_inputs.size();
+				}
+				if (hidden)
+					continue;
+
+				if (parent != NoFolder)
+					m_inputs[parent].file_count++;
+				if (it->is_directory())
+					m_inputs.push_back({.path = std::move(next_path), .name = std::move(curr_fdir_name)});
+				else
+					m_inputs.push_back({.path = std::move(next_path), .name = std::move(curr_fdir_name), .is_file = true, .size = it->file_size()});
+			}
+		}
+	}
 
-			if (entry.is_directory())
-				m_total_bits += FileCountBitsInsideCurrFolder;
-			else
-				count_file_bytes_freq(next_path);
+	/// \brief Counts usage frequency of bytes inside all input files
+	/// Files are counted in parallel - each thread takes the next file which is not counted yet, and counts it in a
+	/// histogram of its own. The histograms are added up at the end.
+	void count_files_bytes_freq() {
+		const auto files = (std::size_t) std::ranges::count_if(m_inputs, &Input::is_file);
+		const auto threads = std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, std::max<std::size_t>(files, 1));
+
+		std::vector<std::array<long int, 256>> histograms(threads);
+		std::atomic<std::size_t> next = 0;
+		auto count = [this, &next](std::array<long int, 256> &histogram) {
+			histogram.fill(0);
+			for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < m_inputs.size();) {
+				if (m_inputs[i].is_file)
+					for_each_block(m_inputs[i].path, [&histogram](std::string_view block) {
+						count_bytes(block, histogram);
+					});
+			}
+		};
+		{
+			std::vector<std::jthread> workers;
+			for (std::size_t i = 1; i < threads; ++i)
+				workers.emplace_back([&, i] { count(histograms[i]); });
+			count(histograms[0]);
 		}
+
+		for (const auto &histogram : histograms)
+			for (unsigned symbol = 0; symbol < m_occurrence_symbol.size(); ++symbol)
+				m_occurrence_symbol[symbol] += histogram[symbol];
 	}
 
 	/// \brief Process the compression and write the compressed file size
 	/// (Manages second from part 2)
 	void process() {
 		for (auto it = m_trie.begin(); it < m_trie.begin() + (long) m_symbols; ++it) {
-			m_char_huffbits[it->character] = it->bit;
+			if (it->code.length > 64)
+				Logger::the([](spdlog::logger logger){
+					logger.log(spdlog::level::err,
+					           "Compressor: Huffman code is longer than 64 bits!");
+				});
+			m_char_huffbits[it->character] = it->code;
 
 			write_from_ch(it->character);
-			write_from_ch(it->bit.size());
-			m_total_bits += it->bit.size() + BitGroups_Second;
+			write_from_ch(it->code.length);
+			m_total_bits += it->code.length + BitGroups_Second;
 
-			write_bytes(it->bit);
-			m_total_bits += it->bit.size() * (it->char_occurrence);
+			write_code(it->code);
+			m_total_bits += it->code.length * (it->char_occurrence);
 		}
 		if (m_total_bits % CHAR_BIT)
 			m_total_bits = m_total_bits / CHAR_BIT + 1;
@@ -334,97 +602,40 @@ public:
 	void all_file_write() {
 		write_file_count(m_files.size());
 
-		for (const auto &item : m_files) {
-			if (!fs::is_directory(item)) {
-				unsigned long size = fs::file_size(item);
-
-				if (m_current_bit_count == CHAR_BIT) {
-					fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-					m_current_bit_count = 0;
-				}
-				m_current_byte <<= 1;
-				m_current_byte |= 1;
-				m_current_bit_count++;
-
-				write_file_size(size);
-				write_file_name(item);
-				write_file_content(item);
+		for (const auto &input : m_inputs) {
+			m_writer.put(input.is_file, 1);
+			if (input.is_file) {
+				write_file_size(input.size);
+				write_file_name(input.name);
+				add_directory_entry(input.path, input.name, true, input.size);
+				write_file_content(input.path);
 			} else {
-				if (m_current_bit_count == CHAR_BIT) {
-					fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-					m_current_bit_count = 0;
-				}
-				m_current_byte <<= 1;
-				m_current_bit_count++;
-
-				write_file_name(item);
-
-				write_folder(item);
+				write_file_name(input.name);
+				add_directory_entry(input.path, input.name, false, 0);
+				write_file_count(input.file_count);
 			}
 		}
-
-		if (m_current_bit_count == CHAR_BIT)
-			fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-		else {
-			m_current_byte <<= CHAR_BIT - m_current_bit_count;
-			fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-		}
 	}
 
-	/// \brief Open dir path and count regular m_files in it.
-	/// Then write this count in compressed file. (Manages third of part 2)
+	/// \brief Records the entry whose contents (or file count, for a folder) are written next in the central directory
 	///
-	/// \param path - string that represents the path to the file/folder
-	void write_folder_files_count(std::string_view path) {
-		int file_count = 0;
-		for (const auto &entry : fs::directory_iterator(path)) {
-			const std::string next_path = entry.path();
-			const std::string curr_fdir_name = &next_path.substr(next_path.find_last_of('/'))[1];
-			if (curr_fdir_name[0] == '.')
-				continue;
-			file_count++;
+	/// \param path - path to the file/folder, as it was found
+	/// \param name - name of the file/folder, as it is written to the compressed file
+	void add_directory_entry(const std::string &path, const std::string &name, bool is_file, uint64_t size) {
+		auto parent = directory::NoParent;
+		if (name != path) {
+			if (auto it = m_directory_folders.find(path.substr(0, path.find_last_of('/'))); it != m_directory_folders.end())
+				parent = it->second;
 		}
-		write_file_count(file_count);
+		if (!is_file)
+			m_directory_folders[path] = m_directory.size();
+		m_directory.push_back({.name = name, .parent = parent, .is_file = is_file, .size = size, .bit_offset = m_writer.position()});
 	}
 
-	/// \brief This function manages all other function to make folder compression available.
-	/// (Manages from third to seventh of part 2 for a folder)
-	///
-	/// \param path - string that represents the path to the file/folder
-	void write_folder(std::string_view path) {
-		write_folder_files_count(path);
-
-		for (const auto &entry : fs::recursive_directory_iterator(path)) {
-			const std::string next_path = entry.path();
-			const std::string curr_fdir_name = &next_path.substr(next_path.find_last_of('/'))[1];
-			if (curr_fdir_name[0] == '.')
-				continue;
-
-			if (!entry.is_directory()) {
-				if (m_current_bit_count == CHAR_BIT) {
-					fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-					m_current_bit_count = 0;
-				}
-				m_current_byte <<= 1;
-				m_current_byte |= 1;
-				m_current_bit_count++;
-
-				write_file_size(entry.file_size());
-				write_file_name(curr_fdir_name);
-				write_file_content(next_path);
-			} else {
-				if (m_current_bit_count == CHAR_BIT) {
-					fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-					m_current_bit_count = 0;
-				}
-				m_current_byte <<= 1;
-				m_current_bit_count++;
-
-				write_file_name(curr_fdir_name);
-
-				write_folder_files_count(next_path);
-			}
-		}
+	/// \brief Appends the central directory (see Directory.h) after the compressed stream
+	void write_directory() {
+		const auto directory = directory::serialize(m_directory, m_writer.position() / CHAR_BIT);
+		fwrite(directory.data(), 1, directory.size(), m_compressed_fp);
 	}
 
 	/// \brief This function translates and writes bytes from current input file to the compressed file.
@@ -432,37 +643,17 @@ public:
 	///
 	/// \param path - string that represents the path to the file/folder
 	void write_file_content(const std::string &path) {
-		const std::string buff = return_file_info(path);
-
-		for (const auto &item : buff)
-			write_bytes(m_char_huffbits[(uint8_t) item]);
+		for_each_block(path, [this](std::string_view block) {
+			for (const auto &item : block)
+				write_code(m_char_huffbits[(uint8_t) item]);
+		});
 	}
 
-	/// \brief Writes provided string bytes to the new compressed file
+	/// \brief Writes the Huffman code of a symbol to the new compressed file
 	///
 	/// \param for_write - string that will be written
-	void write_bytes(std::string_view for_write) {
-		for (const auto &item : for_write) {
-			if (m_current_bit_count == CHAR_BIT) {
-				fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-				m_current_bit_count = 0;
-			}
-			switch (item) {
-			case '1': m_current_byte <<= 1;
-				m_current_byte |= 1;
-				m_current_bit_count++;
-				break;
-			case '0': m_current_byte <<= 1;
-				m_current_bit_count++;
-				break;
-
-			default:
-				Logger::the([](spdlog::logger logger){
-					logger.log(spdlog::level::err,
-					           "Compressor: Function write_bytes incorrect configuration!");
-				});
-			}
-		}
+	void write_code(const HuffCode &code) {
+		m_writer.put(code.bits, code.length);
 	}
 
 	/// \brief This function writes bytes that are translated from current input file's name to the compressed file.
@@ -472,7 +663,7 @@ public:
 	void write_file_name(std::string_view file_name) {
 		write_from_ch(file_name.size());
 		for (const auto &item : file_name)
-			write_bytes(m_char_huffbits[(uint8_t) item]);
+			write_code(m_char_huffbits[(uint8_t) item]);
 	}
 
 	/// \brief This function is writing byte count of current input file to compressed file using 8 bytes.
@@ -501,18 +692,424 @@ public:
 	}
 
 	/// \brief This function is used for writing the uChar to compressed file.
-	/// It does not write it directly as one byte! Instead it mixes uChar and current byte, writes 8 bits of it
-	/// and puts the rest to current byte for later use.
+	/// It does not write it directly as one byte! It is placed right after the bits written so far.
 	///
 	/// \param ch - character
 	void write_from_ch(uint8_t ch) {
-		m_current_byte <<= CHAR_BIT - m_current_bit_count;
-		m_current_byte |= (ch >> m_current_bit_count);
-		fwrite(&m_current_byte, 1, 1, m_compressed_fp);
-		m_current_byte = ch;
+		m_writer.put(ch, CHAR_BIT);
+	}
+};
+}// namespace storage::detail
+
+/// \brief Options of the block container
+struct BlockOptions {
+	std::size_t block_size = block::DefaultBlockSize;//!< size of the uncompressed blocks
+	unsigned threads = 0;                             //!< number of blocks compressed at once, 0 for one per core
+	unsigned lz_level = 0;                            //!< effort of the LZ77 match finder, from 1 to 9, 0 to disable it
+	std::size_t lz_window = block::MaxWindow;         //!< how far back matches are looked for, a power of 2
+};
+
+namespace storage::detail {
+/// \brief Compresses a stream, written in pieces of any size, into the block container (see BlockFormat.h)
+/// The container is passed to a sink in pieces as well, as soon as each batch of blocks is compressed - a block for
+/// each thread. Only the data of a partial block is copied, whole blocks are compressed right out of the written data.
+class BlockStreamInternal {
+public:
+	explicit BlockStreamInternal(BlockOptions options) : m_options(options) {
+		if (m_options.block_size == 0 || m_options.block_size > block::MaxBlockSize) {
+			Logger::the([size = m_options.block_size](spdlog::logger logger){
+				logger.log(spdlog::level::warn, R"(BlockCompressor: Block size "{}" is out of range, using the default one)", size);
+			});
+			m_options.block_size = block::DefaultBlockSize;
+		}
+		if (m_options.threads == 0)
+			m_options.threads = std::max(1u, std::thread::hardware_concurrency());
+		m_options.lz_level = std::min(m_options.lz_level, 9u);
+		if (m_options.lz_window < 256 || m_options.lz_window > block::MaxWindow || !std::has_single_bit(m_options.lz_window)) {
+			Logger::the([window = m_options.lz_window](spdlog::logger logger){
+				logger.log(spdlog::level::warn, R"(BlockCompressor: LZ77 window "{}" is not supported, using the largest one)", window);
+			});
+			m_options.lz_window = block::MaxWindow;
+		}
+	}
+
+	/// \brief Appends 'data' to the stream
+	///
+	/// \param sink - called with each following piece of the container, as a std::span<const uint8_t>
+	void write(std::span<const uint8_t> data, auto &&sink) {
+		const std::string_view view{reinterpret_cast<const char *>(data.data()), data.size()};
+		const auto block_size = m_options.block_size;
+		std::size_t pos = 0;
+		if (!m_pending.empty()) {
+			const auto count = std::min(block_size - m_pending.size(), view.size());
+			m_pending.append(view.substr(0, count));
+			pos = count;
+			if (m_pending.size() < block_size)
+				return;
+			m_batch.push_back(m_pending);
+			flush(sink);
+			m_pending.clear();
+		}
+
+		for (; view.size() - pos >= block_size; pos += block_size) {
+			m_batch.push_back(view.substr(pos, block_size));
+			if (m_batch.size() == m_options.threads)
+				flush(sink);
+		}
+		flush(sink);
+		m_pending.append(view.substr(pos));
+	}
+
+	/// \brief Compresses the last partial block and ends the container with its index and trailer
+	void finish(auto &&sink) {
+		if (!m_pending.empty()) {
+			m_batch.push_back(m_pending);
+			flush(sink);
+			m_pending.clear();
+		}
+		put_header(sink);
+
+		std::vector<uint8_t> tail;
+		tail.reserve(m_index.size() * block::IndexEntrySize + block::TrailerSize);
+		for (const auto &entry : m_index) {
+			block::put_le(tail, entry.offset, 8);
+			block::put_le(tail, entry.compressed_size, 4);
+			block::put_le(tail, entry.raw_size, 4);
+		}
+		block::put_le(tail, m_index.size(), 8);
+		block::put_le(tail, m_offset, 8);
+		sink(std::span<const uint8_t>{tail});
+		m_offset += tail.size();
+	}
+
+	[[nodiscard]] const BlockOptions &options() const noexcept { return m_options; }
+
+	[[nodiscard]] std::size_t blocks() const noexcept { return m_index.size(); }
+
+	/// \brief Size of the container written so far
+	[[nodiscard]] uint64_t size() const noexcept { return m_offset; }
+
+	/// \brief Compresses a single block with Huffman tables of its own (see BlockFormat.h)
+	/// Blocks which coding would not make smaller are stored as they are. The size of the coded block is known from the
+	/// lengths of the codes, so the codes of such blocks are not written at all.
+	static std::vector<uint8_t> encode_block(std::string_view raw, const BlockOptions &options = {}) {
+		BitWriter writer;
+		const bool coded = options.lz_level > 0 ? encode_lz77(raw, options, writer) : encode_huffman(raw, writer);
+		if (!coded)
+			return stored_block(raw);
+		writer.finish();
+		return writer.take();
+	}
+
+	/// \brief The block as it is, after its mode
+	static std::vector<uint8_t> stored_block(std::string_view raw) {
+		std::vector<uint8_t> out;
+		out.reserve(1 + raw.size());
+		out.push_back((uint8_t) block::BlockMode::Stored);
+		out.insert(out.end(), raw.begin(), raw.end());
+		return out;
+	}
+
+	/// \brief Whether a block of 'bits' bits, along with its mode, is smaller than the stored 'raw'
+	static bool smaller_than_stored(uint64_t bits, std::string_view raw) {
+		return (CHAR_BIT + bits + CHAR_BIT - 1) / CHAR_BIT < 1 + raw.size();
+	}
+
+	/// \return whether the block is coded - nothing is written if it would not be smaller than the stored one
+	static bool encode_huffman(std::string_view raw, BitWriter &writer) {
+		std::array<long int, 256> occurrence_symbol{};
+		CompressorInternal::count_bytes(raw, occurrence_symbol);
+		const auto lengths = limited_code_lengths(occurrence_symbol, block::MaxCodeLength);
+
+		uint64_t bits = lengths.size() * block::CodeLengthBits;
+		for (unsigned symbol = 0; symbol < lengths.size(); ++symbol)
+			bits += (uint64_t) occurrence_symbol[symbol] * lengths[symbol];
+		if (!smaller_than_stored(bits, raw))
+			return false;
+
+		const auto codes = canonical_codes(lengths);
+		writer.put((uint8_t) block::BlockMode::Huffman, CHAR_BIT);
+		for (const auto length : lengths)
+			writer.put(length, block::CodeLengthBits);
+		for (const auto &item : raw)
+			writer.put(codes[(uint8_t) item].bits, codes[(uint8_t) item].length);
+		return true;
+	}
+
+	/// \brief A literal byte, when its length is 0, or a match of 'length' bytes 'distance' bytes back
+	struct Token {
+		uint16_t length;
+		uint16_t distance;
+		uint8_t literal;
+	};
+
+	/// \return whether the block is coded - nothing is written if it would not be smaller than the stored one
+	static bool encode_lz77(std::string_view raw, const BlockOptions &options, BitWriter &writer) {
+		auto length_symbol = [](std::size_t length) {
+			return (std::size_t) (std::ranges::upper_bound(block::LengthBase, length) - block::LengthBase.begin() - 1);
+		};
+		auto distance_symbol = [](std::size_t distance) {
+			return (std::size_t) (std::ranges::upper_bound(block::DistanceBase, distance) - block::DistanceBase.begin() - 1);
+		};
+
+		const auto tokens = lz77_tokens(raw, options.lz_level, options.lz_window);
+		std::vector<long int> literal_occurrences(block::LiteralSymbols);
+		std::vector<long int> distance_occurrences(block::DistanceSymbols);
+		for (const auto &token : tokens) {
+			if (token.length == 0) {
+				literal_occurrences[token.literal]++;
+			} else {
+				literal_occurrences[256 + length_symbol(token.length)]++;
+				distance_occurrences[distance_symbol(token.distance)]++;
+			}
+		}
+
+		const auto literal_lengths = limited_code_lengths(literal_occurrences, block::MaxCodeLength);
+		const auto distance_lengths = limited_code_lengths(distance_occurrences, block::MaxCodeLength);
+
+		uint64_t bits = (literal_lengths.size() + distance_lengths.size()) * block::CodeLengthBits;
+		for (std::size_t symbol = 0; symbol < literal_lengths.size(); ++symbol) {
+			const auto extra = symbol < 256 ? 0 : block::LengthExtraBits[symbol - 256];
+			bits += (uint64_t) literal_occurrences[symbol] * (literal_lengths[symbol] + extra);
+		}
+		for (std::size_t symbol = 0; symbol < distance_lengths.size(); ++symbol)
+			bits += (uint64_t) distance_occurrences[symbol] * (distance_lengths[symbol] + block::DistanceExtraBits[symbol]);
+		if (!smaller_than_stored(bits, raw))
+			return false;
+
+		writer.put((uint8_t) block::BlockMode::LZ77, CHAR_BIT);
+		for (const auto length : literal_lengths)
+			writer.put(length, block::CodeLengthBits);
+		for (const auto length : distance_lengths)
+			writer.put(length, block::CodeLengthBits);
+
+		const auto literal_codes = canonical_codes(literal_lengths);
+		const auto distance_codes = canonical_codes(distance_lengths);
+		for (const auto &token : tokens) {
+			if (token.length == 0) {
+				writer.put(literal_codes[token.literal].bits, literal_codes[token.literal].length);
+				continue;
+			}
+			const auto length = length_symbol(token.length);
+			writer.put(literal_codes[256 + length].bits, literal_codes[256 + length].length);
+			writer.put(token.length - block::LengthBase[length], block::LengthExtraBits[length]);
+			const auto distance = distance_symbol(token.distance);
+			writer.put(distance_codes[distance].bits, distance_codes[distance].length);
+			writer.put(token.distance - block::DistanceBase[distance], block::DistanceExtraBits[distance]);
+		}
+		return true;
+	}
+
+	/// \brief Replaces the bytes of 'raw' with literals and matches of the bytes up to 'window' bytes back
+	/// Earlier positions with the same next 3 bytes are found through hash chains - the head of each chain is the
+	/// latest position with that hash, and each position links to the previous one, if it is still in the window.
+	/// The match finder is greedy, and 'level' bounds how many positions of a chain it tries: 2^(level + 1), stopping
+	/// early at a long enough match.
+	static std::vector<Token> lz77_tokens(std::string_view raw, unsigned level, std::size_t window) {
+		static constexpr unsigned HashBits = 15;
+		const std::size_t max_chain = std::size_t{1} << (level + 1);
+		const std::size_t nice_length = level >= 9 ? block::MaxMatch : 16 * level + 16;
+		const std::size_t mask = window - 1;
+
+		std::vector<int32_t> head(std::size_t{1} << HashBits, -1);
+		std::vector<int32_t> prev(window, -1);
+		auto hash = [&raw](std::size_t pos) {
+			const uint32_t next = (uint8_t) raw[pos] << 16 | (uint8_t) raw[pos + 1] << 8 | (uint8_t) raw[pos + 2];
+			return (next * 2654435761u) >> (32 - HashBits);
+		};
+		auto insert = [&](std::size_t pos) {
+			auto &chain = head[hash(pos)];
+			prev[pos & mask] = chain;
+			chain = (int32_t) pos;
+		};
+
+		std::vector<Token> tokens;
+		tokens.reserve(raw.size() / 2);
+		for (std::size_t pos = 0; pos < raw.size();) {
+			std::size_t best_length = 0;
+			std::size_t best_distance = 0;
+			if (pos + block::MinMatch <= raw.size()) {
+				const auto limit = std::min(block::MaxMatch, raw.size() - pos);
+				auto chain = max_chain;
+				for (auto candidate = head[hash(pos)]; candidate >= 0 && pos - candidate <= window && chain-- > 0;) {
+					if (raw[candidate + best_length] == raw[pos + best_length]) {
+						std::size_t length = 0;
+						while (length < limit && raw[candidate + length] == raw[pos + length])
+							++length;
+						if (length > best_length) {
+							best_length = length;
+							best_distance = pos - candidate;
+							if (length >= std::min(nice_length, limit))
+								break;
+						}
+					}
+					/// A link which does not go back belongs to a position which has left the window.
+					const auto next = prev[candidate & mask];
+					if (next >= candidate)
+						break;
+					candidate = next;
+				}
+				insert(pos);
+			}
+
+			if (best_length >= block::MinMatch) {
+				tokens.push_back({.length = (uint16_t) best_length, .distance = (uint16_t) best_distance, .literal = 0});
+				for (auto next = pos + 1; next < pos + best_length && next + block::MinMatch <= raw.size(); ++next)
+					insert(next);
+				pos += best_length;
+			} else {
+				tokens.push_back({.length = 0, .distance = 0, .literal = (uint8_t) raw[pos]});
+				++pos;
+			}
+		}
+		return tokens;
+	}
+
+	/// \brief The canonical codes of the symbols with code lengths 'lengths'
+	static std::vector<HuffCode> canonical_codes(std::span<const uint8_t> lengths) {
+		std::vector<HuffCode> codes(lengths.size());
+		block::canonical_codes(lengths, [&codes](uint16_t symbol, uint64_t bits, unsigned length) {
+			codes[symbol] = HuffCode{.bits = bits, .length = length};
+		});
+		return codes;
+	}
+
+	/// \brief Lengths of the optimal prefix code of the symbols, none of them longer than 'max_length'
+	/// Computed with the package-merge algorithm: the lists of the symbols, sorted by their occurrences, are
+	/// merged with the pairs ("packages") of the cheapest items of the list of the next longer code length, starting
+	/// from max_length. The code of a symbol is as long as the number of times it is part of the cheapest
+	/// 2 * (symbols - 1) items of the last list. A lone used symbol gets a code of one bit.
+	static std::vector<uint8_t> limited_code_lengths(std::span<const long int> occurrence_symbol, unsigned max_length) {
+		struct Item {
+			uint64_t weight;
+			int symbol;             //!< symbol of a leaf, -1 for a package
+			std::size_t first;      //!< position of the first item of a package in the previous list
+		};
+
+		std::vector<Item> leaves;
+		for (unsigned symbol = 0; symbol < occurrence_symbol.size(); ++symbol)
+			if (occurrence_symbol[symbol] > 0)
+				leaves.push_back({.weight = (uint64_t) occurrence_symbol[symbol], .symbol = (int) symbol, .first = 0});
+		std::ranges::stable_sort(leaves, {}, &Item::weight);
+
+		std::vector<uint8_t> lengths(occurrence_symbol.size());
+		if (leaves.size() == 1)
+			lengths[leaves.front().symbol] = 1;
+		if (leaves.size() <= 1)
+			return lengths;
+
+		std::vector<std::vector<Item>> lists{leaves};
+		for (unsigned level = 1; level < max_length; ++level) {
+			const auto &prev = lists.back();
+			std::vector<Item> list;
+			list.reserve(leaves.size() + prev.size() / 2);
+			std::size_t leaf = 0;
+			for (std::size_t first = 0; first + 1 < prev.size(); first += 2) {
+				const Item package{.weight = prev[first].weight + prev[first + 1].weight, .symbol = -1, .first = first};
+				while (leaf < leaves.size() && leaves[leaf].weight <= package.weight)
+					list.push_back(leaves[leaf++]);
+				list.push_back(package);
+			}
+			list.insert(list.end(), leaves.begin() + (long) leaf, leaves.end());
+			lists.push_back(std::move(list));
+		}
+
+		/// The selected items of a list select the first 'count' items of the previous one.
+		std::size_t count = 2 * (leaves.size() - 1);
+		for (auto level = lists.size(); level-- > 0;) {
+			std::size_t packages = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				if (lists[level][i].symbol >= 0)
+					++lengths[lists[level][i].symbol];
+				else
+					++packages;
+			}
+			count = 2 * packages;
+		}
+		return lengths;
 	}
+
+private:
+	void put_header(auto &&sink) {
+		if (m_offset > 0)
+			return;
+		std::vector<uint8_t> header(block::Magic.begin(), block::Magic.end());
+		block::put_le(header, block::Version, 1);
+		block::put_le(header, m_options.block_size, 4);
+		sink(std::span<const uint8_t>{header});
+		m_offset = header.size();
+	}
+
+	/// \brief Compresses the blocks of the batch in parallel and passes them to the sink in their order
+	void flush(auto &&sink) {
+		put_header(sink);
+		if (m_batch.empty())
+			return;
+
+		m_compressed.resize(std::max(m_compressed.size(), m_batch.size()));
+		{
+			std::vector<std::jthread> workers;
+			for (std::size_t i = 1; i < m_batch.size(); ++i)
+				workers.emplace_back([&, i] { m_compressed[i] = encode_block(m_batch[i], m_options); });
+			m_compressed[0] = encode_block(m_batch[0], m_options);
+		}
+
+		for (std::size_t i = 0; i < m_batch.size(); ++i) {
+			sink(std::span<const uint8_t>{m_compressed[i]});
+			m_index.push_back({.offset = m_offset,
+			                   .compressed_size = (uint32_t) m_compressed[i].size(),
+			                   .raw_size = (uint32_t) m_batch[i].size()});
+			m_offset += m_compressed[i].size();
+		}
+		m_batch.clear();
+	}
+
+private:
+	BlockOptions m_options;
+	std::string m_pending;                     //!< data of the partial block
+	std::vector<std::string_view> m_batch;     //!< blocks which are compressed at once
+	std::vector<std::vector<uint8_t>> m_compressed;
+	std::vector<block::IndexEntry> m_index;
+	uint64_t m_offset = 0;                     //!< size of the container passed to the sink
+};
+
+class BlockCompressorInternal {
+public:
+	BlockCompressorInternal(std::string input, std::string compressed_name, BlockOptions options)
+		: m_input(std::move(input)), m_compressed_name(std::move(compressed_name)), m_stream(options) {}
+
+	/// \brief Compresses the input one batch of blocks at a time - a block for each thread
+	/// Blocks are written in their order, so only a batch of blocks is kept in memory.
+	void operator()() {
+		std::ifstream in(m_input, std::ifstream::binary);
+		if (!in) {
+			Logger::the([input = m_input](spdlog::logger logger){
+				logger.log(spdlog::level::err, R"(BlockCompressor: File not found: "{}")", input);
+			});
+			return;
+		}
+		FILE *out = fopen(m_compressed_name.c_str(), "wb");
+		auto sink = [out](std::span<const uint8_t> piece) { fwrite(piece.data(), 1, piece.size(), out); };
+
+		std::vector<uint8_t> batch(m_stream.options().block_size * m_stream.options().threads);
+		while (in.read(reinterpret_cast<char *>(batch.data()), (long) batch.size()) || in.gcount() > 0)
+			m_stream.write(std::span{batch}.first(in.gcount()), sink);
+		m_stream.finish(sink);
+		fclose(out);
+
+		Logger::the([name = m_compressed_name, blocks = m_stream.blocks(), size = m_stream.size()](spdlog::logger logger){
+			logger.log(spdlog::level::info, R"(BlockCompressor: created "{}" with "{}" blocks and size: "{}" bytes)",
+			           name, blocks, size);
+		});
+	}
+
+private:
+	std::string m_input;          //!< path to the file for compress
+	std::string m_compressed_name;//!< new name of the compressed file
+	BlockStreamInternal m_stream;
 };
 }// namespace storage::detail
+
 class Compressor {
 private:
 	using pimpl = storage::detail::CompressorInternal;
@@ -548,4 +1145,77 @@ public:
 		(*compressor_internal)();
 	}
 };
+
+class BlockCompressor {
+private:
+	using pimpl = storage::detail::BlockCompressorInternal;
+	std::unique_ptr<pimpl> compressor_internal;
+
+public:
+	/// \brief Constructor of the compression class with which you
+	/// can compress a file into the block container (see BlockFormat.h)
+	///
+	/// \param input - path to the file for compress
+	/// \param compressed_name - name of the future compressed file
+	/// \param options - size of the blocks and number of threads
+	explicit BlockCompressor(std::string_view input,
+	                         std::string_view compressed_name = "",
+	                         BlockOptions options = {}) {
+		std::string new_compressed_name{compressed_name};
+		if (new_compressed_name.empty())
+			new_compressed_name = std::string{input} + ".eubc";
+
+		compressor_internal = std::make_unique<pimpl>(std::string{input}, new_compressed_name, options);
+	}
+
+	void operator()() {
+		(*compressor_internal)();
+	}
+};
+
+/// \brief Compresses a stream held in memory, written in pieces, into the block container (see BlockFormat.h)
+/// The container is appended to the given buffer as soon as each batch of blocks is compressed, thus
+/// it may be sent on or cleared between the writes.
+class StreamCompressor {
+private:
+	using pimpl = storage::detail::BlockStreamInternal;
+	pimpl compressor_internal;
+
+	static auto append_to(std::vector<std::byte> &out) {
+		return [&out](std::span<const uint8_t> piece) {
+			const auto *begin = reinterpret_cast<const std::byte *>(piece.data());
+			out.insert(out.end(), begin, begin + piece.size());
+		};
+	}
+
+public:
+	/// \param options - size of the blocks, number of threads and LZ77 level
+	explicit StreamCompressor(BlockOptions options = {}) : compressor_internal(options) {}
+
+	/// \brief Appends 'data' to the stream
+	///
+	/// \param out - buffer to which the compressed blocks are appended
+	void write(std::span<const std::byte> data, std::vector<std::byte> &out) {
+		compressor_internal.write({reinterpret_cast<const uint8_t *>(data.data()), data.size()}, append_to(out));
+	}
+
+	/// \brief Ends the stream
+	///
+	/// \param out - buffer to which the last block and the index of the container are appended
+	void finish(std::vector<std::byte> &out) {
+		compressor_internal.finish(append_to(out));
+	}
+};
+
+/// \brief Compresses 'data' into the block container (see BlockFormat.h), held in memory
+///
+/// \param options - size of the blocks, number of threads and LZ77 level
+inline std::vector<std::byte> compress(std::span<const std::byte> data, BlockOptions options = {}) {
+	StreamCompressor compressor{options};
+	std::vector<std::byte> out;
+	out.reserve(block::HeaderSize + data.size() / 2);
+	compressor.write(data, out);
+	compressor.finish(out);
+	return out;
+}
 }// namespace compression
@@ -1,10 +1,30 @@
 #pragma once
 
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <core/Logger.h>
+#include <core/storage/compression/BlockFormat.h>
+#include <core/storage/compression/Directory.h>
 
-static constexpr uint8_t Check = 0b10000000;
 static constexpr int Symbols = 256;
 
+namespace fs = std::filesystem;
+
 /// Decompression algorithm is based on
 /// <a href="http://www.huffmancoding.com/my-uncle/scientific-american">huffman coding</a>
 /// <br> <br>
@@ -32,24 +52,203 @@ static constexpr int Symbols = 256;
 /// **2** whenever we see a new folder we will write sixth then
 ///    start writing the files(and folders) inside the current folder from third to seventh
 namespace decompression {
+namespace block = compression::block;
+
 namespace storage::detail {
+
+/// \brief Reads the compressed stream bit by bit, most significant bit first
+///
+/// The input is read in blocks of BufferSize bytes and up to 64 bits of it are kept in a bit buffer, so that
+/// a few bits can be looked at before deciding how many of them to consume. The input is either a file or a buffer
+/// in memory. Past the end of the input only zero bits are read.
+class BitReader {
+public:
+	static constexpr std::size_t BufferSize = 64 * 1024;
+	static constexpr unsigned MaxPeekBits = 56;//!< bits which are always available after a refill
+
+	BitReader() = default;
+
+	explicit BitReader(FILE *in) : m_in(in), m_buffer(BufferSize) {}
+
+	explicit BitReader(std::span<const uint8_t> in) : m_data(in.data()), m_end(in.size()) {}
+
+	/// \brief The next n bits, without consuming them
+	///
+	/// \param n - number of bits, from 1 to MaxPeekBits
+	uint64_t peek(unsigned n) {
+		if (m_count < n)
+			refill();
+		return m_bits >> (64 - n);
+	}
+
+	/// \brief Drops n bits which have already been peeked at
+	void consume(unsigned n) {
+		m_bits <<= n;
+		m_count -= n;
+	}
+
+	uint64_t read(unsigned n) {
+		if (n == 0)
+			return 0;
+		const uint64_t val = peek(n);
+		consume(n);
+		return val;
+	}
+
+	/// \brief Continues reading from the given bit of the input
+	void seek(uint64_t bit) {
+		if (m_in) {
+			fseeko(m_in, (off_t) (bit / CHAR_BIT), SEEK_SET);
+			m_end = 0;
+			m_pos = 0;
+		} else {
+			m_pos = std::min<std::size_t>(bit / CHAR_BIT, m_end);
+		}
+		m_bits = 0;
+		m_count = 0;
+		if (bit % CHAR_BIT)
+			read((unsigned) (bit % CHAR_BIT));
+	}
+
+private:
+	void refill() {
+		while (m_count <= MaxPeekBits) {
+			if (m_pos == m_end && m_in) {
+				m_end = fread(m_buffer.data(), 1, m_buffer.size(), m_in);
+				m_data = m_buffer.data();
+				m_pos = 0;
+			}
+			const uint64_t byte = m_pos < m_end ? m_data[m_pos++] : 0;
+			m_bits |= byte << (MaxPeekBits - m_count);
+			m_count += CHAR_BIT;
+		}
+	}
+
+	FILE *m_in = nullptr;
+	std::vector<uint8_t> m_buffer;
+	const uint8_t *m_data = nullptr;//!< the bytes which are being read, either m_buffer or the input in memory
+	std::size_t m_pos = 0;
+	std::size_t m_end = 0;
+
+	uint64_t m_bits = 0;   //!< the next bits of the input, aligned to the most significant bit
+	unsigned m_count = 0;  //!< number of valid bits in m_bits
+};
+
+/// \brief Decodes Huffman codes with lookup tables
+///
+/// The root table is indexed by the next RootBits bits of the input. An entry of a code which is not longer than
+/// that holds its symbol and length, and is repeated for all values of the bits which follow the code. The longer
+/// codes share a prefix of RootBits bits whose entry links to a secondary table indexed by the bits after it, and so on
+/// for codes which do not fit in that one either. Most symbols are decoded with a single probe.
+class HuffmanTable {
+public:
+	static constexpr unsigned RootBits = 11;
+
+	/// \brief Code of a symbol, one character ('0' or '1') per bit
+	struct Code {
+		uint16_t symbol;
+		std::string bits;
+	};
+
+	HuffmanTable() = default;
+
+	explicit HuffmanTable(const std::vector<Code> &codes) {
+		std::vector<const Code *> all;
+		for (const auto &code : codes)
+			all.push_back(&code);
+		m_root_bits = build(all, 0);
+	}
+
+	uint16_t decode(BitReader &in) const {
+		std::size_t table = 0;
+		unsigned bits = m_root_bits;
+		for (;;) {
+			const auto &entry = m_entries[table + in.peek(bits)];
+			if (entry.sub_bits == 0) {
+				in.consume(entry.length);
+				return entry.symbol;
+			}
+			in.consume(bits);
+			table = entry.next;
+			bits = entry.sub_bits;
+		}
+	}
+
+private:
+	/// \brief A symbol, or a link to the next table when sub_bits is not 0
+	struct Entry {
+		uint32_t next = 0;   //!< index of the first entry of the next table
+		uint16_t symbol = 0;
+		uint8_t length = 0;  //!< number of bits of the code in this table
+		uint8_t sub_bits = 0;//!< number of bits indexing the next table
+	};
+
+	/// \brief Appends the table of the codes whose first 'depth' bits are already consumed
+	///
+	/// Values of the bits which no code starts with are decoded as symbol 0, which may only happen with a corrupted input.
+	///
+	/// \return number of bits indexing the table, which starts at the first appended entry
+	unsigned build(const std::vector<const Code *> &codes, std::size_t depth) {
+		std::size_t max_length = 1;
+		for (const auto *code : codes)
+			max_length = std::max(max_length, code->bits.size() - depth);
+		const auto bits = static_cast<unsigned>(std::min<std::size_t>(max_length, RootBits));
+
+		const std::size_t table = m_entries.size();
+		m_entries.resize(table + (std::size_t{1} << bits), Entry{.length = static_cast<uint8_t>(bits)});
+
+		std::map<std::size_t, std::vector<const Code *>> longer;
+		for (const auto *code : codes) {
+			const std::size_t length = code->bits.size() - depth;
+			std::size_t prefix = 0;
+			for (std::size_t i = 0; i < std::min<std::size_t>(length, bits); ++i)
+				prefix = prefix << 1 | (code->bits[depth + i] == '1');
+
+			if (length > bits) {
+				longer[prefix].push_back(code);
+				continue;
+			}
+			const std::size_t first = prefix << (bits - length);
+			for (std::size_t i = first; i < first + (std::size_t{1} << (bits - length)); ++i)
+				m_entries[table + i] = Entry{.symbol = code->symbol, .length = static_cast<uint8_t>(length)};
+		}
+
+		for (const auto &[prefix, group] : longer) {
+			const auto next = static_cast<uint32_t>(m_entries.size());
+			const auto sub_bits = build(group, depth + bits);
+			m_entries[table + prefix] = Entry{.next = next, .sub_bits = static_cast<uint8_t>(sub_bits)};
+		}
+		return bits;
+	}
+
+	std::vector<Entry> m_entries;
+	unsigned m_root_bits = 1;
+};
+
 class DecompressorInternal {
 public:
+	static constexpr std::size_t OutputBufferSize = 64 * 1024;
+
 	DecompressorInternal() = default;
 
-	explicit DecompressorInternal(FILE *compressed) : m_compressed(compressed) {}
+	explicit DecompressorInternal(FILE *compressed) : m_compressed(compressed), m_reader(compressed) {}
 
 	/// \brief The main function of decompression class that do all the magic with provided m_files.
 	///
 	/// \param for_decompress name of the folder to decompress (by default it is set to decompress all the files)
 	void operator()(std::string_view for_decompress = "") {
-		fread(&m_symbols, 1, 1, m_compressed);
+		std::optional<std::vector<compression::directory::Entry>> entries;
+		if (!for_decompress.empty())
+			entries = read_directory();
+
+		m_symbols = m_reader.read(CHAR_BIT);
 		if (m_symbols == 0)
 			m_symbols = Symbols;
 
-		m_trie_root = new huff_trie;
-		for (unsigned long i = 0; i < m_symbols; i++)
-			trie_initialization(m_trie_root);
+		std::vector<HuffmanTable::Code> codes(m_symbols);
+		for (auto &code : codes)
+			code = read_code();
+		m_table = HuffmanTable{codes};
 
 		if (for_decompress.empty()) {
 			Logger::the([this](spdlog::logger logger){
@@ -62,30 +261,68 @@ public:
 			       R"(Decompressor: Decompressing files in file/folder: "{}")",
 			       for_decompress);
 			});
-			translation_search("", for_decompress, false);
+			if (entries)
+				translation_directory(*entries, for_decompress);
+			else
+				translation_search("", for_decompress, false);
 		}
 
 		fclose(m_compressed);
-		deallocate_trie(m_trie_root);
 		Logger::the([](spdlog::logger logger){
 			logger.log(spdlog::level::info, "Decompressor: Decompression is completed\n");
 		});
 	}
 
-	/// \brief This structure will be used to represent the trie
-	struct huff_trie {
-		huff_trie *zero{nullptr};
-		huff_trie *one{nullptr};      //!< zero and one bit representation nodes of the m_trie_root
-		char character{'\0'};//!< associated character in the trie node
-	};
-
-	huff_trie *m_trie_root = nullptr;
 	FILE *m_compressed = nullptr;//!< file pinter to the compressed file
+	BitReader m_reader;          //!< reader of the compressed file
+	HuffmanTable m_table;        //!< decoding table of the symbols
 	unsigned long m_symbols = 0; //!< count of the file or folder m_symbols
 
-	uint8_t m_current_byte = '\0';//!< uint8_t value
-	//!< that represents the current byte
-	int m_current_bit_count = 0;        //!< integer value of current bits count
+	/// \brief Reads the central directory from the end of the compressed file, if it has one (see Directory.h)
+	/// Leaves the file at its beginning.
+	///
+	/// \return the entries of the directory
+	std::optional<std::vector<compression::directory::Entry>> read_directory() {
+		namespace directory = compression::directory;
+		std::optional<std::vector<directory::Entry>> entries;
+		std::array<uint8_t, directory::TrailerSize> trailer;
+		if (fseeko(m_compressed, -(off_t) trailer.size(), SEEK_END) == 0
+		    && fread(trailer.data(), 1, trailer.size(), m_compressed) == trailer.size()
+		    && std::equal(directory::Magic.begin(), directory::Magic.end(), trailer.begin() + 8)) {
+			const auto end = (uint64_t) ftello(m_compressed) - trailer.size();
+			const auto offset = block::get_le(trailer, 8);
+			std::vector<uint8_t> data(offset <= end ? end - offset : 0);
+			if (offset <= end && fseeko(m_compressed, (off_t) offset, SEEK_SET) == 0
+			    && fread(data.data(), 1, data.size(), m_compressed) == data.size())
+				entries = directory::parse(data);
+		}
+		fseeko(m_compressed, 0, SEEK_SET);
+		return entries;
+	}
+
+	/// \brief Decompresses the first file or folder named for_decompress, which is found through the central
+	/// directory instead of decoding the files before it
+	///
+	/// \param entries - entries of the central directory
+	/// \param for_decompress - file/folder to decompress
+	void translation_directory(const std::vector<compression::directory::Entry> &entries, std::string_view for_decompress) {
+		const auto it = std::ranges::find(entries, for_decompress, &compression::directory::Entry::name);
+		if (it == entries.end()) {
+			Logger::the([for_decompress](spdlog::logger logger){
+			  logger.log(spdlog::level::err, R"(Decompressor: File "{}" not found)", for_decompress);
+			});
+			return;
+		}
+
+		const auto path = compression::directory::path(entries, it - entries.begin());
+		m_reader.seek(it->bit_offset);
+		if (it->is_file) {
+			translate_file(path, (long) it->size);
+		} else {
+			fs::create_directories(path);
+			translation(path, true);
+		}
+	}
 
 	/// \brief Reads how many folders/files the program is going to create inside
 	/// the main folder. File count was written to the compressed file from least significant byte
@@ -104,15 +341,7 @@ public:
 	///
 	/// \return 1 for file and 0 for folder
 	bool is_file() {
-		bool val;
-		if (m_current_bit_count == 0) {
-			fread(&m_current_byte, 1, 1, m_compressed);
-			m_current_bit_count = CHAR_BIT;
-		}
-		val = m_current_byte & Check;
-		m_current_byte <<= 1;
-		m_current_bit_count--;
-		return val;
+		return m_reader.read(1);
 	}
 
 	/// \brief process_byte_number reads 8 successive bits from compressed file
@@ -120,46 +349,21 @@ public:
 	///
 	/// \return the latter 8 successive bits in uint8_t form
 	uint8_t process_byte_number() {
-		uint8_t val;
-		uint8_t temp_byte;
-		fread(&temp_byte, 1, 1, m_compressed);
-		val = (m_current_byte | (temp_byte >> m_current_bit_count));
-		m_current_byte = temp_byte << (CHAR_BIT - m_current_bit_count);
-		return val;
+		return m_reader.read(CHAR_BIT);
 	}
 
-	/// \brief trie_initialization function reads n successive bits from the compressed file
-	/// and stores it in a leaf of the translation trie,
-	/// after creating that leaf and sometimes after creating nodes that are binding that leaf to the trie.
+	/// \brief read_code reads a unique symbol, the length of its code and the code itself
 	///
-	/// \param node - pointer to the trie node that is going to be created
-	void trie_initialization(huff_trie *node) {
-		char curr_char = (char) process_byte_number();
+	/// \return the code of the symbol
+	HuffmanTable::Code read_code() {
+		HuffmanTable::Code code{.symbol = process_byte_number(), .bits = {}};
 		long len = process_byte_number();
 		if (len == 0)
 			len = Symbols;
 
-		for (int i = 0; i < len; i++) {
-			if (m_current_bit_count == 0) {
-				fread(&m_current_byte, 1, 1, m_compressed);
-				m_current_bit_count = CHAR_BIT;
-			}
-
-			if (m_current_byte & Check) {
-				if (!(node->one))
-					node->one = new huff_trie;
-
-				node = node->one;
-			} else {
-				if (!(node->zero))
-					node->zero = new huff_trie;
-
-				node = node->zero;
-			}
-			m_current_byte <<= 1;
-			m_current_bit_count--;
-		}
-		node->character = curr_char;
+		for (int i = 0; i < len; i++)
+			code.bits.push_back(m_reader.read(1) ? '1' : '0');
+		return code;
 	}
 
 	/// \brief Size was written to the compressed file from least significant byte
@@ -181,15 +385,11 @@ public:
 	///
 	/// \param file_length - length of file name
 	std::string get_name() {
-		huff_trie *node;
 		std::string new_file;
 		int file_length = process_byte_number();
 
-		for (int i = 0; i < file_length; i++) {
-			node = m_trie_root;
-			iterate_over_nodes(&node);
-			new_file.push_back(node->character);
-		}
+		for (int i = 0; i < file_length; i++)
+			new_file.push_back((char) m_table.decode(m_reader));
 		return new_file;
 	}
 
@@ -199,37 +399,29 @@ public:
 	/// \param path - path to the file that is being decoded
 	/// \param size - size of the file that is being decoded
 	void translate_file(const std::string &path, long int size) {
-		huff_trie *node;
-
 		if (path.find('/') != std::string::npos) {
 			fs::create_directories(path.substr(0, path.find_last_of('/')));
 		}
 		std::ofstream new_file(path, std::ios::binary);
+		std::string buffer;
+		buffer.reserve(OutputBufferSize);
 		for (long int i = 0; i < size; i++) {
-			node = m_trie_root;
-			iterate_over_nodes(&node);
-			new_file << node->character;
+			buffer.push_back((char) m_table.decode(m_reader));
+			if (buffer.size() == OutputBufferSize) {
+				new_file.write(buffer.data(), (long) buffer.size());
+				buffer.clear();
+			}
 		}
+		new_file.write(buffer.data(), (long) buffer.size());
 		new_file.close();
 	}
 
-	/// \brief This function iterates over the translation trie and writes the file
-	/// to a newly created file
+	/// \brief Decodes and drops the contents of a file which is not being decompressed
 	///
-	/// \param node - pointer to the current node in the trie
-	void iterate_over_nodes(huff_trie **node) {
-		while ((*node)->zero || (*node)->one) {
-			if (m_current_bit_count == 0) {
-				fread(&m_current_byte, 1, 1, m_compressed);
-				m_current_bit_count = CHAR_BIT;
-			}
-			if (m_current_byte & Check)
-				(*node) = (*node)->one;
-			else
-				(*node) = (*node)->zero;
-			m_current_byte <<= 1;
-			m_current_bit_count--;
-		}
+	/// \param size - size of the file that is being skipped
+	void skip_file(long int size) {
+		for (long int i = 0; i < size; i++)
+			m_table.decode(m_reader);
 	}
 
 	/// \brief translation function is used for creating files and folders inside given path
@@ -300,11 +492,7 @@ public:
 					translate_file(new_path, size);
 					break;
 				}
-				huff_trie *node;
-				for (long int i = 0; i < size; i++) {
-					node = m_trie_root;
-					iterate_over_nodes(&node);
-				}
+				skip_file(size);
 			} else {
 				if (curr_file == for_decompress) {
 					translation(new_path, true);
@@ -318,17 +506,271 @@ public:
 		});
 	}
 
-private:
-	/// \brief deallocate_trie function is used for deallocating trie
+};
+
+class BlockDecompressorInternal {
+public:
+	BlockDecompressorInternal(FILE *compressed, unsigned threads) : m_compressed(compressed), m_threads(threads) {
+		if (m_threads == 0)
+			m_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/// \brief Decompresses a container held in memory, which has to outlive the decompressor
+	BlockDecompressorInternal(std::span<const uint8_t> compressed, unsigned threads) : m_memory(compressed), m_threads(threads) {
+		if (m_threads == 0)
+			m_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	BlockDecompressorInternal(const BlockDecompressorInternal &) = delete;
+	BlockDecompressorInternal &operator=(const BlockDecompressorInternal &) = delete;
+
+	~BlockDecompressorInternal() {
+		if (m_compressed)
+			fclose(m_compressed);
+	}
+
+	/// \brief Decompresses the container into 'output'
+	void operator()(const std::string &output) {
+		if (!read_index())
+			return;
+
+		std::ofstream out(output, std::ios::binary);
+		if (!for_each_block([&out](std::string_view raw) { out.write(raw.data(), (long) raw.size()); }))
+			return;
+
+		Logger::the([output, blocks = m_index.size()](spdlog::logger logger){
+			logger.log(spdlog::level::info, R"(BlockDecompressor: decompressed "{}" blocks to "{}")", blocks, output);
+		});
+	}
+
+	/// \brief Decompresses the whole container into memory
+	///
+	/// \return the uncompressed data, or nothing if the container is invalid
+	std::optional<std::vector<std::byte>> decompress() {
+		if (!read_index())
+			return {};
+
+		/// The raw sizes are not checked by decoding yet, thus a corrupted index may claim more than could be reserved.
+		/// In such case the output grows along with the blocks instead.
+		std::vector<std::byte> out;
+		try {
+			out.reserve(std::accumulate(m_index.begin(), m_index.end(), std::size_t{0},
+			                            [](std::size_t size, const auto &entry) { return size + entry.raw_size; }));
+		} catch (const std::bad_alloc &) {
+		}
+		const bool valid = for_each_block([&out](std::string_view raw) {
+			const auto *begin = reinterpret_cast<const std::byte *>(raw.data());
+			out.insert(out.end(), begin, begin + raw.size());
+		});
+		if (!valid)
+			return {};
+		return out;
+	}
+
+	/// \brief Decompresses the blocks one batch at a time - a block for each thread
+	/// Should be called after read_index.
 	///
-	/// \param node - pointer to the current node in the trie
-	void deallocate_trie(huff_trie *node) {
-		if (node->zero)
-			deallocate_trie(node->zero);
-		if (node->one)
-			deallocate_trie(node->one);
-		delete node;
+	/// \param sink - called with each uncompressed block, as a std::string_view, in their order
+	/// \return whether all blocks are valid
+	bool for_each_block(auto &&sink) {
+		std::vector<std::vector<uint8_t>> buffers(m_threads);
+		std::vector<std::span<const uint8_t>> compressed(m_threads);
+		std::vector<std::string> raw(m_threads);
+		for (std::size_t first = 0; first < m_index.size(); first += m_threads) {
+			const std::size_t batch = std::min<std::size_t>(m_threads, m_index.size() - first);
+			for (std::size_t i = 0; i < batch; ++i) {
+				const auto &entry = m_index[first + i];
+				const auto block = read_at(entry.offset, entry.compressed_size, buffers[i]);
+				if (!block) {
+					Logger::the([block = first + i](spdlog::logger logger){
+						logger.log(spdlog::level::err, R"(BlockDecompressor: Block "{}" is truncated)", block);
+					});
+					return false;
+				}
+				compressed[i] = *block;
+				raw[i].resize(entry.raw_size);
+			}
+
+			std::vector<uint8_t> decoded(batch);
+			{
+				std::vector<std::jthread> workers;
+				for (std::size_t i = 1; i < batch; ++i)
+					workers.emplace_back([&, i] { decoded[i] = decode_block(compressed[i], raw[i], m_version); });
+				decoded[0] = decode_block(compressed[0], raw[0], m_version);
+			}
+			if (const auto corrupted = std::ranges::find(decoded, false); corrupted != decoded.end()) {
+				Logger::the([block = first + (corrupted - decoded.begin())](spdlog::logger logger){
+					logger.log(spdlog::level::err, R"(BlockDecompressor: Block "{}" is corrupted)", block);
+				});
+				return false;
+			}
+
+			for (std::size_t i = 0; i < batch; ++i)
+				sink(std::string_view{raw[i]});
+		}
+		return true;
+	}
+
+	/// \brief Decompresses a single block (see BlockFormat.h) into 'out', whose size is the one of the uncompressed block
+	///
+	/// \return whether the block is valid - only the matches of LZ77 blocks, the size of stored blocks and their mode are checked
+	static bool decode_block(std::span<const uint8_t> in, std::span<char> out, uint8_t version = block::Version) {
+		BitReader reader{in};
+		if (version == 1) {
+			std::vector<HuffmanTable::Code> codes(reader.read(CHAR_BIT) + 1);
+			for (auto &code : codes) {
+				code.symbol = reader.read(CHAR_BIT);
+				const auto length = reader.read(CHAR_BIT);
+				for (std::size_t i = 0; i < length; ++i)
+					code.bits.push_back(reader.read(1) ? '1' : '0');
+			}
+			decode_huffman(HuffmanTable{codes}, reader, out);
+			return true;
+		}
+
+		const auto mode = version == 2 ? block::BlockMode::Huffman : static_cast<block::BlockMode>(reader.read(CHAR_BIT));
+		switch (mode) {
+			case block::BlockMode::Huffman:
+				decode_huffman(read_table(reader, 256), reader, out);
+				return true;
+			case block::BlockMode::LZ77:
+				return decode_lz77(reader, out);
+			case block::BlockMode::Stored:
+				if (in.size() != 1 + out.size())
+					return false;
+				std::memcpy(out.data(), in.data() + 1, out.size());
+				return true;
+		}
+		return false;
 	}
+
+	static void decode_huffman(const HuffmanTable &table, BitReader &reader, std::span<char> out) {
+		for (auto &item : out)
+			item = (char) table.decode(reader);
+	}
+
+	static bool decode_lz77(BitReader &reader, std::span<char> out) {
+		const auto literals = read_table(reader, block::LiteralSymbols);
+		const auto distances = read_table(reader, block::DistanceSymbols);
+		for (std::size_t pos = 0; pos < out.size();) {
+			const auto symbol = literals.decode(reader);
+			if (symbol < 256) {
+				out[pos++] = (char) symbol;
+				continue;
+			}
+
+			const std::size_t length_symbol = symbol - 256;
+			const std::size_t length = block::LengthBase[length_symbol] + reader.read(block::LengthExtraBits[length_symbol]);
+			const std::size_t distance_symbol = distances.decode(reader);
+			if (distance_symbol >= block::DistanceSymbols)
+				return false;
+			const std::size_t distance = block::DistanceBase[distance_symbol] + reader.read(block::DistanceExtraBits[distance_symbol]);
+			if (distance > pos || length > out.size() - pos)
+				return false;
+
+			/// The match may overlap the bytes it produces, so it is copied one byte at a time.
+			for (std::size_t i = 0; i < length; ++i, ++pos)
+				out[pos] = out[pos - distance];
+		}
+		return true;
+	}
+
+	/// \brief Reads the code lengths of 'symbols' symbols and builds the table of their canonical codes
+	static HuffmanTable read_table(BitReader &reader, std::size_t symbols) {
+		std::vector<uint8_t> lengths(symbols);
+		for (auto &length : lengths)
+			length = reader.read(block::CodeLengthBits);
+
+		std::vector<HuffmanTable::Code> codes;
+		block::canonical_codes(lengths, [&codes](uint16_t symbol, uint64_t bits, unsigned length) {
+			auto &code = codes.emplace_back(HuffmanTable::Code{.symbol = symbol, .bits = std::string(length, '0')});
+			for (unsigned i = 0; i < length; ++i)
+				code.bits[length - 1 - i] = bits >> i & 1 ? '1' : '0';
+		});
+		return HuffmanTable{codes};
+	}
+
+	/// \brief Reads the header, the trailer and the index of the blocks
+	///
+	/// \return whether the container is valid
+	bool read_index() {
+		auto invalid = [](std::string_view reason) {
+			Logger::the([reason](spdlog::logger logger){
+				logger.log(spdlog::level::err, R"(BlockDecompressor: Invalid container: {})", reason);
+			});
+			return false;
+		};
+
+		std::vector<uint8_t> buffer;
+		const auto header = read_at(0, block::HeaderSize, buffer);
+		if (!header || !std::equal(block::Magic.begin(), block::Magic.end(), header->begin()))
+			return invalid("not a block container");
+		m_version = (*header)[block::Magic.size()];
+		if (m_version < block::MinVersion || m_version > block::Version)
+			return invalid("unsupported version");
+
+		const auto size = container_size();
+		const auto trailer = size < block::HeaderSize + block::TrailerSize
+		                             ? std::nullopt
+		                             : read_at(size - block::TrailerSize, block::TrailerSize, buffer);
+		if (!trailer)
+			return invalid("missing trailer");
+
+		/// The number of blocks is checked before it is multiplied, so that a corrupted one cannot wrap around.
+		const auto blocks = block::get_le(*trailer, 8);
+		const auto index_offset = block::get_le(trailer->subspan(8), 8);
+		if (blocks > (size - block::HeaderSize - block::TrailerSize) / block::IndexEntrySize
+		    || index_offset != size - block::TrailerSize - blocks * block::IndexEntrySize)
+			return invalid("index out of bounds");
+
+		const auto index = read_at(index_offset, blocks * block::IndexEntrySize, buffer);
+		if (!index)
+			return invalid("truncated index");
+
+		m_index.resize(blocks);
+		for (std::size_t i = 0; i < blocks; ++i) {
+			const auto entry = index->subspan(i * block::IndexEntrySize);
+			m_index[i] = {.offset = block::get_le(entry, 8),
+			              .compressed_size = (uint32_t) block::get_le(entry.subspan(8), 4),
+			              .raw_size = (uint32_t) block::get_le(entry.subspan(12), 4)};
+			if (m_index[i].offset > index_offset || m_index[i].compressed_size > index_offset - m_index[i].offset)
+				return invalid("block out of bounds");
+			if (m_index[i].raw_size > block::MaxBlockSize)
+				return invalid("block too large");
+		}
+		return true;
+	}
+
+private:
+	/// \brief 'size' bytes of the container, starting at 'offset'
+	/// Those of a container in memory are not copied, the ones of a file are read into 'buffer'.
+	std::optional<std::span<const uint8_t>> read_at(uint64_t offset, std::size_t size, std::vector<uint8_t> &buffer) {
+		if (!m_compressed) {
+			if (offset > m_memory.size() || size > m_memory.size() - offset)
+				return {};
+			return m_memory.subspan(offset, size);
+		}
+
+		buffer.resize(size);
+		fseeko(m_compressed, (off_t) offset, SEEK_SET);
+		if (fread(buffer.data(), 1, size, m_compressed) != size)
+			return {};
+		return std::span<const uint8_t>{buffer};
+	}
+
+	uint64_t container_size() {
+		if (!m_compressed)
+			return m_memory.size();
+		fseeko(m_compressed, 0, SEEK_END);
+		return (uint64_t) ftello(m_compressed);
+	}
+
+private:
+	FILE *m_compressed = nullptr;          //!< file pointer to the compressed file, if it is not in memory
+	std::span<const uint8_t> m_memory;     //!< the compressed container, if it is in memory
+	unsigned m_threads;                    //!< number of blocks decompressed at once
+	uint8_t m_version = block::Version;
+	std::vector<block::IndexEntry> m_index;
 };
 }// namespace storage::detail
 
@@ -361,4 +803,59 @@ public:
 		(*decompressor_impl)(for_decompress);
 	}
 };
+
+class BlockDecompressor {
+private:
+	using pimpl = storage::detail::BlockDecompressorInternal;
+	std::unique_ptr<pimpl> decompressor_impl;
+
+public:
+	/// \brief Constructor of the decompression class of the block container (see BlockFormat.h)
+	///
+	/// \param path - path to the compressed file
+	/// \param threads - number of blocks decompressed at once, 0 for one per core
+	explicit BlockDecompressor(std::string_view path, unsigned threads = 0) {
+		FILE *path_to_compressed = fopen(std::string{path}.c_str(), "rb");
+		if (!path_to_compressed) {
+			Logger::the([path](spdlog::logger logger){
+				logger.log(spdlog::level::err, R"(BlockDecompressor: File not found: "{}")", path);
+			});
+			return;
+		}
+		decompressor_impl = std::make_unique<pimpl>(path_to_compressed, threads);
+	}
+
+	/// \brief Decompresses the whole container
+	///
+	/// \param output - path to the decompressed file
+	void operator()(const std::string &output) {
+		if (decompressor_impl)
+			(*decompressor_impl)(output);
+	}
+};
+
+/// \brief Decompresses the block container (see BlockFormat.h) held in memory
+///
+/// \param compressed - the whole container
+/// \param threads - number of blocks decompressed at once, 0 for one per core
+/// \return the uncompressed data, or nothing if the container is invalid
+inline std::optional<std::vector<std::byte>> decompress(std::span<const std::byte> compressed, unsigned threads = 1) {
+	storage::detail::BlockDecompressorInternal decompressor{
+	        {reinterpret_cast<const uint8_t *>(compressed.data()), compressed.size()}, threads};
+	return decompressor.decompress();
+}
+
+/// \brief Decompresses the block container (see BlockFormat.h) held in memory, a block at a time
+///
+/// \param compressed - the whole container
+/// \param sink - called with each uncompressed block, as a std::span<const std::byte>, in their order
+/// \param threads - number of blocks decompressed at once, 0 for one per core
+/// \return whether the container is valid - the sink may have been called with some of its blocks even if it is not
+inline bool decompress(std::span<const std::byte> compressed, auto &&sink, unsigned threads = 1) {
+	storage::detail::BlockDecompressorInternal decompressor{
+	        {reinterpret_cast<const uint8_t *>(compressed.data()), compressed.size()}, threads};
+	return decompressor.read_index() && decompressor.for_each_block([&sink](std::string_view raw) {
+		sink(std::span<const std::byte>{reinterpret_cast<const std::byte *>(raw.data()), raw.size()});
+	});
+}
 }// namespace decompression
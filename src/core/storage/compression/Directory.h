@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <core/storage/compression/BlockFormat.h>
+
+/// Central directory of a compressed bundle
+/// <br> <br>
+/// Appended after the last byte of the compressed stream, so that a single file or folder can be decompressed without
+/// decoding the ones before it. Bundles without a directory are still decompressed by walking the whole stream.
+/// <ul>
+///     <li>(varint) -> number of entries</li>
+///     <li>for each entry, in the order in which they are in the stream
+///         <ul>
+///             <li>(1 byte) -> file(1) or folder(0)</li>
+///             <li>(varint) -> position of the parent folder in the directory plus 1, 0 for the top-level entries</li>
+///             <li>(varint) -> size of the file</li>
+///             <li>(varint) -> bit offset in the stream of the contents of the file or of the file count of the folder</li>
+///             <li>(varint) -> length of the name, followed by the name</li>
+///         </ul>
+///     </li>
+///     <li>(8 bytes) -> offset of the directory in the bundle</li>
+///     <li>(8 bytes) -> magic "EUHUFDIR"</li>
+/// </ul>
+namespace compression::directory {
+
+static constexpr std::array<uint8_t, 8> Magic = {'E', 'U', 'H', 'U', 'F', 'D', 'I', 'R'};
+static constexpr std::size_t TrailerSize = 16;
+static constexpr uint64_t NoParent = UINT64_MAX;
+
+struct Entry {
+	std::string name;
+	uint64_t parent = NoParent;//!< position of the parent folder in the directory
+	bool is_file = false;
+	uint64_t size = 0;
+	uint64_t bit_offset = 0;
+};
+
+inline void put_varint(std::vector<uint8_t> &out, uint64_t val) {
+	for (; val >= 0x80; val >>= 7)
+		out.push_back(static_cast<uint8_t>(val | 0x80));
+	out.push_back(static_cast<uint8_t>(val));
+}
+
+inline std::optional<uint64_t> get_varint(std::span<const uint8_t> in, std::size_t &pos) {
+	uint64_t val = 0;
+	for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+		const auto byte = in[pos++];
+		val |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return val;
+	}
+	return {};
+}
+
+/// \brief The directory, along with its trailer, to be placed at byte 'offset' of the bundle
+inline std::vector<uint8_t> serialize(const std::vector<Entry> &entries, uint64_t offset) {
+	std::vector<uint8_t> out;
+	put_varint(out, entries.size());
+	for (const auto &entry : entries) {
+		out.push_back(entry.is_file);
+		put_varint(out, entry.parent == NoParent ? 0 : entry.parent + 1);
+		put_varint(out, entry.size);
+		put_varint(out, entry.bit_offset);
+		put_varint(out, entry.name.size());
+		out.insert(out.end(), entry.name.begin(), entry.name.end());
+	}
+	block::put_le(out, offset, 8);
+	out.insert(out.end(), Magic.begin(), Magic.end());
+	return out;
+}
+
+/// \brief Parses the entries of a directory, without its trailer
+///
+/// \return the entries, or nothing if the directory is malformed
+inline std::optional<std::vector<Entry>> parse(std::span<const uint8_t> in) {
+	std::size_t pos = 0;
+	const auto count = get_varint(in, pos);
+	if (!count || *count > in.size())
+		return {};
+
+	std::vector<Entry> entries(*count);
+	for (std::size_t i = 0; i < entries.size(); ++i) {
+		auto &entry = entries[i];
+		if (pos >= in.size())
+			return {};
+		entry.is_file = in[pos++];
+		const auto parent = get_varint(in, pos);
+		const auto size = get_varint(in, pos);
+		const auto bit_offset = get_varint(in, pos);
+		const auto name_size = get_varint(in, pos);
+		if (!parent || !size || !bit_offset || !name_size || *parent > i || *name_size > in.size() - pos)
+			return {};
+		entry.parent = *parent == 0 ? NoParent : *parent - 1;
+		entry.size = *size;
+		entry.bit_offset = *bit_offset;
+		entry.name.assign(in.begin() + (long) pos, in.begin() + (long) (pos + *name_size));
+		pos += *name_size;
+	}
+	return entries;
+}
+
+/// \brief Path of the entry, as it is created by decompression
+inline std::string path(const std::vector<Entry> &entries, std::size_t i) {
+	if (entries[i].parent == NoParent)
+		return entries[i].name;
+	return path(entries, entries[i].parent) + "/" + entries[i].name;
+}
+
+}// namespace compression::directory
@@ -0,0 +1,300 @@
+#include <core/storage/compression/tests/Shared.h>
+
+void block_round_trip(const std::string &text, compression::BlockOptions options) {
+	const std::string file_name = "block.txt";
+	const std::string compressed_name = "block.eubc";
+	const std::string decompressed_name = "block.out";
+
+	std::ofstream(file_name, std::ios::binary) << text;
+	compression::BlockCompressor{file_name, compressed_name, options}();
+	REQUIRE(exists(compressed_name));
+
+	decompression::BlockDecompressor{compressed_name, options.threads}(decompressed_name);
+	REQUIRE(exists(decompressed_name));
+	REQUIRE(compression::storage::detail::CompressorInternal::return_file_info(decompressed_name) == text);
+
+	REQUIRE(clean({{"file_name", file_name},
+	               {"compressed_name", compressed_name},
+	               {"decompressed_name", decompressed_name}}));
+}
+
+TEST_CASE("Block container round trip", "[block]") {
+	SECTION("Many blocks, the last one partial") {
+		std::string text;
+		while (text.size() < 100 * 1024 + 123)
+			text += generate_random_string_sequence(34);
+		block_round_trip(text, {.block_size = 4 * 1024, .threads = 4});
+		block_round_trip(text, {.block_size = 4 * 1024, .threads = 1});
+	}
+
+	SECTION("Empty file") {
+		block_round_trip("", {.block_size = 4 * 1024, .threads = 2});
+	}
+
+	SECTION("Block with a single symbol") {
+		block_round_trip(std::string(10 * 1024, 'a'), {.block_size = 4 * 1024, .threads = 2});
+	}
+}
+
+TEST_CASE("Block container does not depend on the number of threads", "[block]") {
+	const std::string file_name = "block.txt";
+	std::ofstream(file_name, std::ios::binary) << generate_random_string_sequence(64 * 1024);
+
+	compression::BlockCompressor{file_name, "single.eubc", {.block_size = 4 * 1024, .threads = 1}}();
+	compression::BlockCompressor{file_name, "parallel.eubc", {.block_size = 4 * 1024, .threads = 8}}();
+
+	using compr = compression::storage::detail::CompressorInternal;
+	REQUIRE(compr::return_file_info("single.eubc") == compr::return_file_info("parallel.eubc"));
+	check_initial_compressed_size(file_name, "parallel.eubc");
+
+	REQUIRE(clean({{"file_name", file_name},
+	               {"single", "single.eubc"},
+	               {"parallel", "parallel.eubc"}}));
+}
+
+TEST_CASE("Block container rejects other files", "[block]") {
+	const std::string file_name = "block.txt";
+	std::ofstream(file_name, std::ios::binary) << generate_random_string_sequence(1024);
+
+	decompression::BlockDecompressor{file_name}("block.out");
+	REQUIRE(!exists("block.out"));
+
+	REQUIRE(clean({{"file_name", file_name}}));
+}
+
+TEST_CASE("Block container code lengths", "[block]") {
+	using block_compr = compression::storage::detail::BlockStreamInternal;
+	using compr = compression::storage::detail::CompressorInternal;
+
+	auto kraft_sum = [](std::span<const uint8_t> lengths) {
+		uint64_t sum = 0;
+		for (const auto length : lengths)
+			if (length > 0)
+				sum += uint64_t{1} << (compression::block::MaxCodeLength - length);
+		return sum;
+	};
+
+	SECTION("Limited to MaxCodeLength") {
+		/// Unlimited Huffman codes of the Fibonacci frequencies are as long as the number of symbols.
+		std::array<long int, 256> occurrence_symbol{};
+		for (long a = 1, b = 1, c = 0; c < 30; ++c) {
+			occurrence_symbol[c] = a;
+			b = std::exchange(a, a + b);
+		}
+		const auto lengths = block_compr::limited_code_lengths(occurrence_symbol, compression::block::MaxCodeLength);
+		REQUIRE(std::ranges::max(lengths) == compression::block::MaxCodeLength);
+		REQUIRE(kraft_sum(lengths) == uint64_t{1} << compression::block::MaxCodeLength);
+
+		std::string text;
+		for (unsigned c = 0; c < 24; ++c)
+			text.append(occurrence_symbol[c], (char) ('a' + c));
+		block_round_trip(text, {.block_size = 1024 * 1024, .threads = 1});
+	}
+
+	SECTION("Optimal when the limit is not reached") {
+		std::array<long int, 256> occurrence_symbol{};
+		for (auto &item : generate_random_string_sequence(10 * 1024))
+			occurrence_symbol[(uint8_t) item]++;
+		const auto lengths = block_compr::limited_code_lengths(occurrence_symbol, compression::block::MaxCodeLength);
+		const auto codes = compr::huffman_codes(occurrence_symbol);
+
+		long int limited_cost = 0;
+		long int huffman_cost = 0;
+		for (unsigned c = 0; c < 256; ++c) {
+			limited_cost += occurrence_symbol[c] * lengths[c];
+			huffman_cost += occurrence_symbol[c] * (long) codes[c].length;
+		}
+		REQUIRE(limited_cost == huffman_cost);
+		REQUIRE(kraft_sum(lengths) == uint64_t{1} << compression::block::MaxCodeLength);
+	}
+
+	SECTION("Version 1 blocks") {
+		/// Codes 'a' -> 0 and 'b' -> 1, stored along with their symbols
+		compression::storage::detail::BitWriter writer;
+		writer.put(1, CHAR_BIT);
+		writer.put('a', CHAR_BIT);
+		writer.put(1, CHAR_BIT);
+		writer.put(0, 1);
+		writer.put('b', CHAR_BIT);
+		writer.put(1, CHAR_BIT);
+		writer.put(1, 1);
+		writer.put(0b0110, 4);
+		writer.finish();
+
+		std::string raw(4, 0);
+		REQUIRE(decompression::storage::detail::BlockDecompressorInternal::decode_block(writer.take(), raw, 1));
+		REQUIRE(raw == "abba");
+	}
+
+	SECTION("Version 2 blocks") {
+		/// Version 2 blocks have no mode, only the Huffman code lengths: 'a' -> 0 and 'b' -> 1
+		compression::storage::detail::BitWriter writer;
+		for (unsigned c = 0; c < 256; ++c)
+			writer.put(c == 'a' || c == 'b', compression::block::CodeLengthBits);
+		writer.put(0b1001, 4);
+		writer.finish();
+
+		std::string raw(4, 0);
+		REQUIRE(decompression::storage::detail::BlockDecompressorInternal::decode_block(writer.take(), raw, 2));
+		REQUIRE(raw == "baab");
+	}
+}
+
+TEST_CASE("Block container LZ77", "[block]") {
+	/// Log lines differ only in a few fields, which is what LZ77 finds and Huffman coding alone does not.
+	std::string text;
+	for (int i = 0; text.size() < 256 * 1024; ++i)
+		text += fmt::format("2026-10-18 12:{:02}:{:02} INFO [worker-{}] GET /api/v1/users/{} completed with status 200 in {} ms\n",
+		                    i / 60 % 60, i % 60, i % 8, rand() % 10000, rand() % 500);
+
+	SECTION("Round trip") {
+		for (unsigned level : {1, 6, 9})
+			block_round_trip(text, {.block_size = 64 * 1024, .threads = 2, .lz_level = level});
+		block_round_trip(text, {.block_size = 64 * 1024, .threads = 2, .lz_level = 6, .lz_window = 1024});
+		block_round_trip(generate_random_string_sequence(64 * 1024), {.block_size = 16 * 1024, .threads = 2, .lz_level = 6});
+		block_round_trip(std::string(10 * 1024, 'a'), {.block_size = 4 * 1024, .threads = 2, .lz_level = 6});
+		block_round_trip("ab", {.block_size = 4 * 1024, .threads = 1, .lz_level = 6});
+	}
+
+	SECTION("Smaller than Huffman coding alone") {
+		using block_compr = compression::storage::detail::BlockStreamInternal;
+		const auto huffman = block_compr::encode_block(text);
+		const auto lz77 = block_compr::encode_block(text, {.lz_level = 6});
+		REQUIRE(lz77.size() * 3 < text.size());
+		REQUIRE(lz77.size() * 2 < huffman.size());
+	}
+
+	SECTION("Corrupted matches are rejected") {
+		/// A single match, one byte back, at the very beginning of the block
+		compression::storage::detail::BitWriter writer;
+		writer.put((uint8_t) compression::block::BlockMode::LZ77, CHAR_BIT);
+		for (unsigned symbol = 0; symbol < compression::block::LiteralSymbols; ++symbol)
+			writer.put(symbol == 'a' || symbol == 256, compression::block::CodeLengthBits);
+		for (unsigned symbol = 0; symbol < compression::block::DistanceSymbols; ++symbol)
+			writer.put(symbol == 0, compression::block::CodeLengthBits);
+		writer.put(0b10, 2);
+		writer.finish();
+
+		std::string raw(3, 0);
+		REQUIRE(!decompression::storage::detail::BlockDecompressorInternal::decode_block(writer.take(), raw));
+	}
+}
+
+TEST_CASE("Block container in memory", "[block]") {
+	std::string text;
+	while (text.size() < 100 * 1024 + 123)
+		text += generate_random_string_sequence(34);
+	const auto data = std::as_bytes(std::span{text});
+	const compression::BlockOptions options{.block_size = 4 * 1024, .threads = 2};
+
+	SECTION("Same container as the one of a file") {
+		const auto compressed = compression::compress(data, options);
+
+		std::ofstream("block.txt", std::ios::binary) << text;
+		compression::BlockCompressor{"block.txt", "block.eubc", options}();
+		const auto file = compression::storage::detail::CompressorInternal::return_file_info("block.eubc");
+		REQUIRE(std::ranges::equal(std::as_bytes(std::span{file}), compressed));
+		REQUIRE(clean({{"file_name", "block.txt"}, {"compressed_name", "block.eubc"}}));
+
+		const auto decompressed = decompression::decompress(compressed);
+		REQUIRE(decompressed);
+		REQUIRE(std::ranges::equal(*decompressed, data));
+	}
+
+	SECTION("Streaming") {
+		/// Pieces which are not aligned to the blocks, the compressed ones are taken out right away
+		compression::StreamCompressor compressor{options};
+		std::vector<std::byte> compressed;
+		std::vector<std::byte> out;
+		for (std::size_t pos = 0; pos < data.size(); pos += 1000) {
+			compressor.write(data.subspan(pos, std::min<std::size_t>(1000, data.size() - pos)), out);
+			compressed.insert(compressed.end(), out.begin(), out.end());
+			out.clear();
+		}
+		compressor.finish(out);
+		compressed.insert(compressed.end(), out.begin(), out.end());
+		REQUIRE(compressed == compression::compress(data, options));
+
+		std::vector<std::byte> decompressed;
+		std::size_t blocks = 0;
+		REQUIRE(decompression::decompress(compressed, [&](std::span<const std::byte> raw) {
+			decompressed.insert(decompressed.end(), raw.begin(), raw.end());
+			++blocks;
+		}));
+		REQUIRE(blocks == (data.size() + options.block_size - 1) / options.block_size);
+		REQUIRE(std::ranges::equal(decompressed, data));
+	}
+
+	SECTION("Empty and invalid buffers") {
+		const auto empty = decompression::decompress(compression::compress({}, options));
+		REQUIRE(empty);
+		REQUIRE(empty->empty());
+
+		auto compressed = compression::compress(data, options);
+		REQUIRE(!decompression::decompress(std::span{compressed}.first(compressed.size() - 1)));
+		REQUIRE(!decompression::decompress(data));
+	}
+
+	SECTION("Corrupted index") {
+		const auto compressed = compression::compress(data, options);
+		auto patched = [&compressed](std::size_t offset, uint64_t val, std::size_t bytes) {
+			auto corrupted = compressed;
+			for (std::size_t i = 0; i < bytes; ++i, val >>= 8)
+				corrupted[offset + i] = std::byte(val & 0xFF);
+			return corrupted;
+		};
+		const auto trailer = compressed.size() - compression::block::TrailerSize;
+		const auto blocks = (data.size() + options.block_size - 1) / options.block_size;
+		const auto index = trailer - blocks * compression::block::IndexEntrySize;
+
+		/// Number of blocks whose index size wraps around
+		REQUIRE(!decompression::decompress(patched(trailer, blocks + (uint64_t{1} << 60), 8)));
+		/// Raw size of a block larger than any block could be
+		REQUIRE(!decompression::decompress(patched(index + 12, std::numeric_limits<uint32_t>::max(), 4)));
+		REQUIRE(!decompression::decompress(patched(index + 12, compression::block::MaxBlockSize + 1, 4)));
+		/// Block beyond the index
+		REQUIRE(!decompression::decompress(patched(index, std::numeric_limits<uint64_t>::max(), 8)));
+	}
+}
+
+TEST_CASE("Block container stores incompressible blocks", "[block]") {
+	using block_compr = compression::storage::detail::BlockStreamInternal;
+	using block_mode = compression::block::BlockMode;
+
+	/// All byte values, as often as each other, as in already compressed data
+	std::string random(64 * 1024, 0);
+	for (auto &item : random)
+		item = static_cast<char>(::random());
+	const std::string text = generate_random_string_sequence(64 * 1024);
+
+	SECTION("Mode of the blocks") {
+		for (unsigned level : {0, 6}) {
+			const auto stored = block_compr::encode_block(random, {.lz_level = level});
+			REQUIRE(stored.size() == 1 + random.size());
+			REQUIRE(stored[0] == (uint8_t) block_mode::Stored);
+
+			const auto coded = block_compr::encode_block(text, {.lz_level = level});
+			REQUIRE(coded[0] != (uint8_t) block_mode::Stored);
+			REQUIRE(coded.size() < text.size());
+		}
+	}
+
+	SECTION("Round trip") {
+		block_round_trip(random + text + random.substr(100), {.block_size = 16 * 1024, .threads = 2});
+		block_round_trip(random + text + random.substr(100), {.block_size = 16 * 1024, .threads = 2, .lz_level = 6});
+	}
+
+	SECTION("No expansion besides the mode of the blocks") {
+		const compression::BlockOptions options{.block_size = 16 * 1024, .threads = 1};
+		const auto compressed = compression::compress(std::as_bytes(std::span{random}), options);
+		const std::size_t blocks = random.size() / options.block_size;
+		REQUIRE(compressed.size() == compression::block::HeaderSize + random.size()
+		                             + blocks * (1 + compression::block::IndexEntrySize) + compression::block::TrailerSize);
+	}
+
+	SECTION("Stored blocks of another size are rejected") {
+		const std::vector<uint8_t> stored{(uint8_t) block_mode::Stored, 'a'};
+		std::string raw(2, 0);
+		REQUIRE(!decompression::storage::detail::BlockDecompressorInternal::decode_block(stored, raw));
+	}
+}
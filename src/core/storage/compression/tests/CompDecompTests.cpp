@@ -46,4 +46,31 @@ TEST_CASE("CompDecomp comp_decomp", "[compressor_decompressor]") {
 		folder_test(params,
 		            (int) pow(10, i),
 		            text_in_file);
-}
\ No newline at end of file
+}
+
+/// \brief Symbols with Fibonacci frequencies get codes longer than a single decoding table probe
+TEST_CASE("CompDecomp long_codes", "[compressor_decompressor]") {
+	const std::string file_name = "long_codes.txt";
+	const std::string compressed_name = "long_codes";
+	const std::string initial_name = "long_codes_initial.txt";
+
+	std::string text;
+	for (long a = 1, b = 1, c = 'a'; c <= 'x'; ++c) {
+		text.append(a, (char) c);
+		b = std::exchange(a, a + b);
+	}
+	std::ofstream(file_name, std::ios::binary) << text;
+
+	compression::Compressor{std::vector<std::string>(1, file_name), compressed_name}();
+	REQUIRE(exists(compressed_name));
+	check_initial_compressed_size(file_name, compressed_name);
+
+	fs::rename(file_name, initial_name);
+	decompression::Decompressor{compressed_name}();
+	REQUIRE(exists(file_name));
+	REQUIRE(compression::storage::detail::CompressorInternal::return_file_info(file_name) == text);
+
+	REQUIRE(clean({{"file_name", file_name},
+	               {"compressed_name", compressed_name},
+	               {"initial_name", initial_name}}));
+}
@@ -25,4 +25,67 @@ TEST_CASE("Compressor specific_file_size_test", "[specific_file_size_test]") {
 	check_initial_compressed_size(file_name, compressed_file_name);
 	REQUIRE(clean({{"file_name", file_name},
 	               {"compressed_file_name", compressed_file_name}}));
-}
\ No newline at end of file
+}
+
+TEST_CASE("Compressor count_bytes", "[count_bytes]") {
+	using compr = compression::storage::detail::CompressorInternal;
+	for (const std::size_t size : {0, 1, 7, 8, 9, 1000, 64 * 1024 + 3}) {
+		std::string text = generate_random_string_sequence(size);
+		/// Long runs of the same byte are counted the same way
+		for (std::size_t i = size / 2; i < size; ++i)
+			text[i] = 'x';
+
+		std::array<long int, 256> expected{};
+		for (const auto &item : text)
+			expected[(uint8_t) item]++;
+
+		std::array<long int, 256> counted{};
+		compr::count_bytes(text, counted);
+		REQUIRE(counted == expected);
+
+		/// Occurrences are added to the ones counted so far
+		compr::count_bytes(text, counted);
+		for (auto &item : expected)
+			item *= 2;
+		REQUIRE(counted == expected);
+	}
+}
+
+TEST_CASE("Compressor list_inputs", "[list_inputs]") {
+	using compr = compression::storage::detail::CompressorInternal;
+	const std::string folder_name = "list_inputs";
+	REQUIRE(create_testing_directory(folder_name, 4, "text"));
+	std::ofstream(folder_name + "/.hidden") << "hidden";
+
+	compr compressor{{folder_name + "/"}, "compressed"};
+	compressor.list_inputs();
+
+	/// The folder, its file and its 2 sub-folders, each of which holds a file
+	REQUIRE(compressor.m_inputs.size() == 6);
+	REQUIRE(compressor.m_inputs[0].name == folder_name + "/");
+	std::size_t files = 0;
+	for (const auto &input : compressor.m_inputs) {
+		REQUIRE(input.name[0] != '.');
+		if (!input.is_file)
+			REQUIRE(input.file_count == (&input == &compressor.m_inputs[0] ? 3 : 1));
+		if (input.is_file) {
+			REQUIRE(input.size == 16);
+			REQUIRE(input.size == fs::file_size(input.path));
+			++files;
+		}
+	}
+	REQUIRE(files == 3);
+
+	/// Each file is counted once, along with the names
+	std::array<long int, 256> expected{};
+	for (const auto &input : compressor.m_inputs)
+		for (const auto &item : input.name + (input.is_file ? std::string("texttexttexttext") : ""))
+			expected[(uint8_t) item]++;
+	for (const auto &input : compressor.m_inputs)
+		for (const auto &item : input.name)
+			compressor.m_occurrence_symbol[(uint8_t) item]++;
+	compressor.count_files_bytes_freq();
+	REQUIRE(compressor.m_occurrence_symbol == expected);
+
+	REQUIRE(clean({{"folder_name", folder_name}}));
+}
@@ -39,4 +39,42 @@ TEST_CASE("CompressorDecompressor partial_decompress", "[partial_decompress]") {
 	std::cout << "Success" << std::endl;
 	std::cout << "#############################################################\n\n";
 	REQUIRE(clean(params));
-}
\ No newline at end of file
+}
+
+TEST_CASE("CompressorDecompressor partial_decompress_directory", "[partial_decompress]") {
+	std::map<std::string, std::string> params;
+	params["test_dir_name"] = "ForTesting";
+	params["changed_to_initial_dir"] = "InitialDir";
+	params["compressed_name"] = "Test";
+
+	REQUIRE(create_testing_directory(params["test_dir_name"], 1000, generate_random_string_sequence(34)));
+	compression::Compressor{std::vector<std::string>(1, params["test_dir_name"]), params["compressed_name"]}();
+	REQUIRE(exists(params["compressed_name"]));
+	fs::rename(params["test_dir_name"], params["changed_to_initial_dir"]);
+
+	using compr = compression::storage::detail::CompressorInternal;
+	auto partial_decompress = [&params] {
+		decompression::Decompressor{params["compressed_name"]}("2");
+		REQUIRE(exists("ForTesting/2/file.txt"));
+		REQUIRE(!exists("ForTesting/1"));
+		REQUIRE(compr::return_file_info("ForTesting/2/file.txt") == compr::return_file_info("InitialDir/2/file.txt"));
+		fs::remove_all(params["test_dir_name"]);
+	};
+
+	/// Found through the central directory
+	partial_decompress();
+
+	/// Found by decoding the files before it, without the central directory
+	{
+		std::ifstream compressed(params["compressed_name"], std::ios::binary);
+		compressed.seekg(-16, std::ios::end);
+		uint64_t directory_offset = 0;
+		compressed.read(reinterpret_cast<char *>(&directory_offset), sizeof(directory_offset));
+		compressed.close();
+		fs::resize_file(params["compressed_name"], directory_offset);
+	}
+	partial_decompress();
+
+	REQUIRE(clean({{"changed_to_initial_dir", params["changed_to_initial_dir"]},
+	               {"compressed_name", params["compressed_name"]}}));
+}
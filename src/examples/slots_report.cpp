@@ -0,0 +1,41 @@
+#include <cstdlib>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include <fmt/core.h>
+
+#include <core/storage/Pager.h>
+
+using namespace internal::storage;
+
+/// Prints how well the Slots pages of a pager are utilized
+/// The pager is the one that stores the dynamic values of a tree - for a tree named 'tree' it is 'tree-indvector-pager'.
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		fmt::print("Usage: {} <pager>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	const std::string pager_name{argv[1]};
+	if (!fs::exists(pager_name) || !fs::exists(fmt::format("{}-alloc", pager_name))) {
+		fmt::print("'{}' is not a saved pager\n", pager_name);
+		return EXIT_FAILURE;
+	}
+
+	Pager<> pager{pager_name, ActionOnConstruction::Load};
+	const auto report = pager.fragmentation_report();
+
+	fmt::print("=== Slots pages of '{}' ===\n", pager_name);
+	fmt::print(" pages:                {}\n", report.pages);
+	fmt::print(" slots pages:          {} ({} empty)\n", report.slots_pages, report.empty_slots_pages);
+	fmt::print(" live bytes:           {}\n", report.live_bytes);
+	fmt::print(" allocated bytes:      {}\n", report.allocated_bytes);
+	fmt::print(" space amplification:  {:.2f}\n", report.space_amplification());
+	fmt::print(" compaction gain:      {} bytes\n", report.compaction_gain());
+	fmt::print(" largest free run:     {} bytes\n", report.largest_free_run);
+	fmt::print(" free runs:\n");
+	for (const auto &[order, count] : report.free_runs)
+		fmt::print("  [{}, {}) bytes: {}\n", 1ul << order, 1ul << (order + 1), count);
+
+	return EXIT_SUCCESS;
+}